@@ -10,7 +10,7 @@
         ['bastian_engine == "v8"', {
           'dependencies': [
             './deps/v8/tools/gyp/v8.gyp:v8_libbase',
-            './deps/v8/tools/gyp/v8.gyp:v8_snapshot',
+            './snapshot.gyp:bastian_snapshot',
             './deps/v8/tools/gyp/v8.gyp:v8_libplatform',
             './deps/v8/tools/gyp/v8.gyp:v8_base'
           ]
@@ -24,11 +24,21 @@
         }]
       ],
       'sources': [
+        'src/arena.cc',
+        'src/bind.cc',
+        'src/callsite.cc',
+        'src/codecache.cc',
         'src/engine.cc',
         'src/fcontext.cc',
+        'src/json.cc',
         'src/objcontext.cc',
+        'src/persistent.cc',
+        'src/platform.cc',
+        'src/pool.cc',
         'src/propcontext.cc',
         'src/runcontext.cc',
+        'src/script.cc',
+        'src/scriptcache.cc',
         'src/value.cc'
       ]
     }
@@ -1,11 +1,20 @@
 #ifndef BASTIAN_ROOT_H_
 #define BASTIAN_ROOT_H_
 
+#include "../src/arena.h"
+#include "../src/bind.h"
+#include "../src/callsite.h"
 #include "../src/engine.h"
 #include "../src/fcontext.h"
 #include "../src/handle.h"
+#include "../src/json.h"
 #include "../src/objcontext.h"
+#include "../src/persistent.h"
+#include "../src/platform.h"
+#include "../src/pool.h"
 #include "../src/runcontext.h"
+#include "../src/script.h"
+#include "../src/scriptcache.h"
 #include "../src/value.h"
 
 #endif  // BASTIAN_ROOT_H_
\ No newline at end of file
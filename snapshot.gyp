@@ -0,0 +1,94 @@
+{
+  'variables': {
+    'v8_code': 1,
+    'v8_random_seed%': 314159265,
+    'bastian_prelude%': 'src/prelude.js',
+  },
+  'includes': [
+    './deps/v8/build/toolchain.gypi',
+    './deps/v8/build/features.gypi',
+  ],
+  'targets': [
+    {
+      # Same as v8_snapshot, with the bastian prelude evaluated in the
+      # snapshot context so that new contexts start with it.
+      'target_name': 'bastian_snapshot',
+      'type': 'static_library',
+      'conditions': [
+        ['want_separate_host_toolset==1', {
+          'toolsets': ['host', 'target'],
+          'dependencies': [
+            './deps/v8/tools/gyp/v8.gyp:mksnapshot#host',
+            './deps/v8/tools/gyp/v8.gyp:js2c#host',
+          ],
+        }, {
+          'toolsets': ['target'],
+          'dependencies': [
+            './deps/v8/tools/gyp/v8.gyp:mksnapshot',
+            './deps/v8/tools/gyp/v8.gyp:js2c',
+          ],
+        }],
+      ],
+      'dependencies': [
+        './deps/v8/tools/gyp/v8.gyp:v8_base',
+      ],
+      'include_dirs+': [
+        './deps/v8',
+      ],
+      'sources': [
+        '<(SHARED_INTERMEDIATE_DIR)/libraries.cc',
+        '<(SHARED_INTERMEDIATE_DIR)/experimental-libraries.cc',
+        '<(INTERMEDIATE_DIR)/snapshot.cc',
+        '<(INTERMEDIATE_DIR)/snapshot_fingerprint.cc',
+        './deps/v8/src/snapshot-common.cc',
+      ],
+      'actions': [
+        {
+          'action_name': 'run_mksnapshot_with_prelude',
+          'inputs': [
+            '<(PRODUCT_DIR)/<(EXECUTABLE_PREFIX)mksnapshot<(EXECUTABLE_SUFFIX)',
+            '<(bastian_prelude)',
+          ],
+          'outputs': [
+            '<(INTERMEDIATE_DIR)/snapshot.cc',
+          ],
+          'variables': {
+            'mksnapshot_flags': [
+              '--log-snapshot-positions',
+              '--logfile', '<(INTERMEDIATE_DIR)/snapshot.log',
+            ],
+            'conditions': [
+              ['v8_random_seed!=0', {
+                'mksnapshot_flags': ['--random-seed', '<(v8_random_seed)'],
+              }],
+            ],
+          },
+          'action': [
+            '<(PRODUCT_DIR)/<(EXECUTABLE_PREFIX)mksnapshot<(EXECUTABLE_SUFFIX)',
+            '<@(mksnapshot_flags)',
+            '--extra-code', '<(bastian_prelude)',
+            '<@(INTERMEDIATE_DIR)/snapshot.cc'
+          ],
+        },
+        {
+          # Keys the code cache, see src/codecache.cc.
+          'action_name': 'fingerprint_snapshot',
+          'inputs': [
+            './tools/snapshot_fingerprint.py',
+            '<(INTERMEDIATE_DIR)/snapshot.cc',
+          ],
+          'outputs': [
+            '<(INTERMEDIATE_DIR)/snapshot_fingerprint.cc',
+          ],
+          'action': [
+            'python',
+            './tools/snapshot_fingerprint.py',
+            '<(INTERMEDIATE_DIR)/snapshot_fingerprint.cc',
+            '<(CONFIGURATION_NAME)-<(target_arch)',
+            '<(INTERMEDIATE_DIR)/snapshot.cc',
+          ],
+        },
+      ],
+    },
+  ],
+}
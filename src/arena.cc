@@ -0,0 +1,111 @@
+// Copyright David Corticchiato
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "./arena.h"
+
+#include <cstddef>
+
+
+namespace bastian {
+
+// Every allocation is preceded by a header naming its block, NULL for the
+// ones made with malloc. A block filled during a call is chained to the
+// next one and freed once the call returns.
+struct CallArena::Block {
+  Block* previous;
+  size_t used;
+  alignas(16) char data[kBlockSize];
+};
+
+union CallArena::Header {
+  Block* block;
+  std::max_align_t alignment;
+};
+
+thread_local CallArena::Block* CallArena::block_ = NULL;
+thread_local int CallArena::depth_ = 0;
+
+CallArena::Scope::Scope() {
+  ++depth_;
+}
+
+CallArena::Scope::~Scope() {
+  if (--depth_ > 0 || block_ == NULL) {
+    return;
+  }
+
+  while (block_->previous != NULL) {
+    Block* previous = block_->previous;
+    block_->previous = previous->previous;
+    std::free(previous);
+  }
+
+  block_->used = 0;
+}
+
+void* CallArena::Allocate(size_t size) {
+  size_t length = (sizeof(Header) + size + 15) & ~static_cast<size_t>(15);
+  Header* header;
+
+  if (depth_ == 0 || length > kBlockSize) {
+    header = static_cast<Header*>(std::malloc(sizeof(Header) + size));
+
+    if (header == NULL) {
+      std::abort();
+    }
+
+    header->block = NULL;
+    return header + 1;
+  }
+
+  if (block_ == NULL || block_->used + length > kBlockSize) {
+    Block* block = static_cast<Block*>(std::malloc(sizeof(Block)));
+
+    if (block == NULL) {
+      std::abort();
+    }
+
+    block->previous = block_;
+    block->used = 0;
+    block_ = block;
+  }
+
+  header = reinterpret_cast<Header*>(block_->data + block_->used);
+  header->block = block_;
+  block_->used += length;
+
+  return header + 1;
+}
+
+// Arena allocations are reclaimed together when the call returns.
+void CallArena::Free(void* pointer) {
+  if (pointer == NULL) {
+    return;
+  }
+
+  Header* header = static_cast<Header*>(pointer) - 1;
+
+  if (header->block == NULL) {
+    std::free(header);
+  }
+}
+
+}  // namespace bastian
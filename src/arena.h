@@ -0,0 +1,63 @@
+// Copyright David Corticchiato
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef BASTIAN_ARENA_H_
+#define BASTIAN_ARENA_H_
+
+#include <cstdlib>
+
+
+namespace bastian {
+
+// Bump allocator for what a native function needs until it returns, the
+// argument memos and the characters of string arguments. The arena is
+// rewound when the outermost call returns, its allocations must not be
+// used past that. Values do not come from the arena, they may outlive the
+// call.
+//
+// Allocations made outside of a call or larger than a block go to malloc.
+class CallArena {
+ public:
+  class Scope {
+   public:
+    Scope();
+    ~Scope();
+
+   private:
+    Scope(const Scope&);
+    Scope& operator= (const Scope&);
+  };
+
+  static void* Allocate(size_t size);
+  static void Free(void* pointer);
+
+ private:
+  struct Block;
+  union Header;
+
+  static const size_t kBlockSize = 4096;
+  static thread_local Block* block_;
+  static thread_local int depth_;
+};
+
+}  // namespace bastian
+
+#endif  // BASTIAN_ARENA_H_
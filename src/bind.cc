@@ -0,0 +1,150 @@
+// Copyright David Corticchiato
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "./bind.h"
+
+#include <cmath>
+
+
+namespace bastian {
+
+//
+// V8 Bindings
+//
+
+
+#ifdef BASTIAN_V8
+
+string_view NativeStringView(v8::Local<v8::Value> value, std::string* buffer) {
+  v8::Local<v8::String> string = value->IsString() ?
+    value.As<v8::String>() :
+    value->ToString();
+  string_view view;
+
+  // ToString threw, the exception is left pending.
+  if (string.IsEmpty()) {
+    view.data = "";
+    view.length = 0;
+    return view;
+  }
+
+  if (string->IsExternalAscii()) {
+    const v8::String::ExternalAsciiStringResource* resource =
+      string->GetExternalAsciiStringResource();
+
+    view.data = resource->data();
+    view.length = resource->length();
+    return view;
+  }
+
+  buffer->resize(string->Utf8Length());
+
+  if (!buffer->empty()) {
+    string->WriteUtf8(
+      &(*buffer)[0],
+      static_cast<int>(buffer->size()),
+      NULL,
+      v8::String::NO_NULL_TERMINATION);
+  }
+
+  view.data = buffer->data();
+  view.length = buffer->size();
+  return view;
+}
+
+void SetNativeString(
+    const v8::FunctionCallbackInfo<v8::Value>& info,
+    string_view result) {
+  info.GetReturnValue().Set(v8::String::NewFromUtf8(
+    info.GetIsolate(),
+    result.data,
+    v8::String::kNormalString,
+    static_cast<int>(result.length)));
+}
+
+#endif
+
+
+//
+// JSC Bindings
+//
+
+
+#ifdef BASTIAN_JSC
+
+static double NativeModulo32(double value) {
+  static const double two_32 = 4294967296.0;
+
+  if (!std::isfinite(value)) {
+    return 0;
+  }
+
+  value = std::fmod(std::trunc(value), two_32);
+
+  return value < 0 ? value + two_32 : value;
+}
+
+int32_t NativeToInt32(double value) {
+  double modulo = NativeModulo32(value);
+
+  return static_cast<int32_t>(
+    modulo >= 2147483648.0 ? modulo - 4294967296.0 : modulo);
+}
+
+uint32_t NativeToUint32(double value) {
+  return static_cast<uint32_t>(NativeModulo32(value));
+}
+
+string_view NativeStringView(
+    JSContextRef context_ref,
+    JSValueRef value,
+    JSValueRef* exception,
+    std::string* buffer) {
+  JSStringRef string = JSValueToStringCopy(context_ref, value, exception);
+
+  if (string == NULL) {
+    buffer->clear();
+
+    string_view view = { "", 0 };
+    return view;
+  }
+
+  buffer->resize(JSStringGetMaximumUTF8CStringSize(string));
+  buffer->resize(
+    JSStringGetUTF8CString(string, &(*buffer)[0], buffer->size()) - 1);
+  JSStringRelease(string);
+
+  string_view view = { buffer->data(), buffer->size() };
+  return view;
+}
+
+JSValueRef MakeNativeString(JSContextRef context_ref, string_view result) {
+  std::string terminated(result.data, result.length);
+  JSStringRef string = JSStringCreateWithUTF8CString(terminated.c_str());
+  JSValueRef value = JSValueMakeString(context_ref, string);
+
+  JSStringRelease(string);
+
+  return value;
+}
+
+#endif
+
+}  // namespace bastian
@@ -0,0 +1,616 @@
+// Copyright David Corticchiato
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef BASTIAN_BIND_H_
+#define BASTIAN_BIND_H_
+
+#ifdef BASTIAN_V8
+#include <v8.h>
+#endif
+
+#ifdef BASTIAN_JSC
+#include <JavascriptCore/JavascriptCore.h>
+#endif
+
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "./arena.h"
+#include "./handle.h"
+#include "./value.h"
+
+
+namespace bastian {
+
+// Native functions whose signature is known at compile time are bound
+// without a function context: the arguments are converted straight from
+// the engine's values to the parameter types and the result straight
+// back. Parameters and results may be double, int32_t, uint32_t, bool,
+// std::string, string_view or Handle<Value>, the result may be void.
+//
+//   double Add(double a, double b) { return a + b; }
+//   obj->Export("add", BASTIAN_BIND(Add));
+//
+// Arguments convert as the engine does, a missing argument is undefined.
+// A string_view argument is only valid during the call. When a conversion
+// throws, the function is not called and the exception is thrown back to
+// the script.
+#define BASTIAN_BIND(FuncName) \
+  bastian::Bind<decltype(&FuncName), &FuncName>()
+
+template<typename T>
+class NativeArgument {
+  static_assert(sizeof(T) == 0, "Unsupported parameter type");
+};
+
+template<typename T>
+struct NativeResult {
+  static_assert(sizeof(T) == 0, "Unsupported result type");
+};
+
+template<size_t... Indices>
+struct NativeIndices {};
+
+template<size_t Count, size_t... Indices>
+struct MakeNativeIndices
+  : MakeNativeIndices<Count - 1, Count - 1, Indices...> {};
+
+template<size_t... Indices>
+struct MakeNativeIndices<0, Indices...> {
+  typedef NativeIndices<Indices...> Type;
+};
+
+template<typename Signature, Signature function>
+class NativeBinding;
+
+
+//
+// V8 Bindings
+//
+
+
+#ifdef BASTIAN_V8
+
+typedef void (*native_function)(const v8::FunctionCallbackInfo<v8::Value>&);
+
+// Characters of a string argument, written to buffer unless the string
+// is external. Empty when the conversion throws.
+string_view NativeStringView(v8::Local<v8::Value> value, std::string* buffer);
+void SetNativeString(
+  const v8::FunctionCallbackInfo<v8::Value>& info,
+  string_view result);
+
+template<>
+class NativeArgument<double> {
+ public:
+  void Convert(v8::Local<v8::Value> value) {
+    value_ = value->IsNumber() ?
+      value.As<v8::Number>()->Value() :
+      value->NumberValue();
+  }
+
+  double Get() { return value_; }
+
+ private:
+  double value_;
+};
+
+template<>
+class NativeArgument<int32_t> {
+ public:
+  void Convert(v8::Local<v8::Value> value) {
+    value_ = value->IsInt32() ?
+      static_cast<int32_t>(value.As<v8::Integer>()->Value()) :
+      value->Int32Value();
+  }
+
+  int32_t Get() { return value_; }
+
+ private:
+  int32_t value_;
+};
+
+template<>
+class NativeArgument<uint32_t> {
+ public:
+  void Convert(v8::Local<v8::Value> value) {
+    value_ = value->Uint32Value();
+  }
+
+  uint32_t Get() { return value_; }
+
+ private:
+  uint32_t value_;
+};
+
+template<>
+class NativeArgument<bool> {
+ public:
+  void Convert(v8::Local<v8::Value> value) {
+    value_ = value->BooleanValue();
+  }
+
+  bool Get() { return value_; }
+
+ private:
+  bool value_;
+};
+
+template<>
+class NativeArgument<string_view> {
+ public:
+  void Convert(v8::Local<v8::Value> value) {
+    view_ = NativeStringView(value, &buffer_);
+  }
+
+  string_view Get() { return view_; }
+
+ private:
+  std::string buffer_;
+  string_view view_;
+};
+
+template<>
+class NativeArgument<std::string> {
+ public:
+  void Convert(v8::Local<v8::Value> value) {
+    string_view view = NativeStringView(value, &value_);
+
+    if (view.data != value_.data()) {
+      value_.assign(view.data, view.length);
+    }
+  }
+
+  const std::string& Get() { return value_; }
+
+ private:
+  std::string value_;
+};
+
+template<>
+class NativeArgument<Handle<Value>> {
+ public:
+  void Convert(v8::Local<v8::Value> value) {
+    value_ = value->IsString() ?
+      String::Wrap(value.As<v8::String>()) :
+      Value::New(value);
+  }
+
+  ~NativeArgument() {
+    String::Unwrap(value_);
+  }
+
+  const Handle<Value>& Get() { return value_; }
+
+ private:
+  Handle<Value> value_;
+};
+
+template<>
+struct NativeResult<double> {
+  static void Set(const v8::FunctionCallbackInfo<v8::Value>& info, double r) {
+    info.GetReturnValue().Set(r);
+  }
+};
+
+template<>
+struct NativeResult<int32_t> {
+  static void Set(const v8::FunctionCallbackInfo<v8::Value>& info, int32_t r) {
+    info.GetReturnValue().Set(r);
+  }
+};
+
+template<>
+struct NativeResult<uint32_t> {
+  static void Set(const v8::FunctionCallbackInfo<v8::Value>& info, uint32_t r) {
+    info.GetReturnValue().Set(r);
+  }
+};
+
+template<>
+struct NativeResult<bool> {
+  static void Set(const v8::FunctionCallbackInfo<v8::Value>& info, bool r) {
+    info.GetReturnValue().Set(r);
+  }
+};
+
+template<>
+struct NativeResult<string_view> {
+  static void Set(
+      const v8::FunctionCallbackInfo<v8::Value>& info,
+      string_view r) {
+    SetNativeString(info, r);
+  }
+};
+
+template<>
+struct NativeResult<std::string> {
+  static void Set(
+      const v8::FunctionCallbackInfo<v8::Value>& info,
+      const std::string& r) {
+    string_view view = { r.data(), r.size() };
+    SetNativeString(info, view);
+  }
+};
+
+template<>
+struct NativeResult<Handle<Value>> {
+  static void Set(
+      const v8::FunctionCallbackInfo<v8::Value>& info,
+      const Handle<Value>& r) {
+    info.GetReturnValue().Set(r->Extract());
+  }
+};
+
+template<typename R>
+struct NativeCall {
+  template<typename Function, typename... Arguments>
+  static void Invoke(
+      const v8::FunctionCallbackInfo<v8::Value>& info,
+      const v8::TryCatch& try_catch,
+      Function function,
+      Arguments&&... arguments) {
+    if (!try_catch.HasCaught()) {
+      NativeResult<typename std::decay<R>::type>::Set(
+        info, function(std::forward<Arguments>(arguments)...));
+    }
+  }
+};
+
+template<>
+struct NativeCall<void> {
+  template<typename Function, typename... Arguments>
+  static void Invoke(
+      const v8::FunctionCallbackInfo<v8::Value>& info,
+      const v8::TryCatch& try_catch,
+      Function function,
+      Arguments&&... arguments) {
+    if (!try_catch.HasCaught()) {
+      function(std::forward<Arguments>(arguments)...);
+    }
+  }
+};
+
+template<typename R, typename... Args, R (*function)(Args...)>
+class NativeBinding<R (*)(Args...), function> {
+ public:
+  static void Callback(const v8::FunctionCallbackInfo<v8::Value>& info) {
+    CallArena::Scope arena_scope;
+    v8::TryCatch try_catch;
+
+    Call(info, try_catch, typename MakeNativeIndices<sizeof...(Args)>::Type());
+
+    if (try_catch.HasCaught()) {
+      try_catch.ReThrow();
+    }
+  }
+
+ private:
+  // The arguments are converted left to right, as scripts coerce them, in
+  // a braced list which orders the conversions. Once a conversion threw,
+  // the others convert undefined.
+  template<size_t... Indices>
+  static void Call(
+      const v8::FunctionCallbackInfo<v8::Value>& info,
+      const v8::TryCatch& try_catch,
+      NativeIndices<Indices...>) {
+    std::tuple<NativeArgument<typename std::decay<Args>::type>...> converted;
+    int expand[] = { 0, (std::get<Indices>(converted).Convert(
+      try_catch.HasCaught() ?
+        v8::Undefined(info.GetIsolate()).As<v8::Value>() :
+        info[Indices]), 0)... };
+
+    (void) expand;
+
+    NativeCall<R>::Invoke(
+      info,
+      try_catch,
+      function,
+      std::get<Indices>(converted).Get()...);
+  }
+};
+
+#endif
+
+
+//
+// JSC Bindings
+//
+
+
+#ifdef BASTIAN_JSC
+
+typedef JSValueRef (*native_function)(
+    JSContextRef,
+    JSObjectRef,
+    JSObjectRef,
+    size_t,
+    const JSValueRef*,
+    JSValueRef*);
+
+// Same conversions as the ECMAScript ToInt32 and ToUint32.
+int32_t NativeToInt32(double value);
+uint32_t NativeToUint32(double value);
+string_view NativeStringView(
+  JSContextRef context_ref,
+  JSValueRef value,
+  JSValueRef* exception,
+  std::string* buffer);
+JSValueRef MakeNativeString(JSContextRef context_ref, string_view result);
+
+template<>
+class NativeArgument<double> {
+ public:
+  void Convert(
+      JSContextRef context_ref,
+      JSValueRef value,
+      JSValueRef* exception) {
+    value_ = JSValueToNumber(context_ref, value, exception);
+  }
+
+  double Get() { return value_; }
+
+ private:
+  double value_;
+};
+
+template<>
+class NativeArgument<int32_t> {
+ public:
+  void Convert(
+      JSContextRef context_ref,
+      JSValueRef value,
+      JSValueRef* exception) {
+    value_ = NativeToInt32(JSValueToNumber(context_ref, value, exception));
+  }
+
+  int32_t Get() { return value_; }
+
+ private:
+  int32_t value_;
+};
+
+template<>
+class NativeArgument<uint32_t> {
+ public:
+  void Convert(
+      JSContextRef context_ref,
+      JSValueRef value,
+      JSValueRef* exception) {
+    value_ = NativeToUint32(JSValueToNumber(context_ref, value, exception));
+  }
+
+  uint32_t Get() { return value_; }
+
+ private:
+  uint32_t value_;
+};
+
+template<>
+class NativeArgument<bool> {
+ public:
+  void Convert(
+      JSContextRef context_ref,
+      JSValueRef value,
+      JSValueRef* exception) {
+    value_ = JSValueToBoolean(context_ref, value);
+  }
+
+  bool Get() { return value_; }
+
+ private:
+  bool value_;
+};
+
+template<>
+class NativeArgument<string_view> {
+ public:
+  void Convert(
+      JSContextRef context_ref,
+      JSValueRef value,
+      JSValueRef* exception) {
+    view_ = NativeStringView(context_ref, value, exception, &buffer_);
+  }
+
+  string_view Get() { return view_; }
+
+ private:
+  std::string buffer_;
+  string_view view_;
+};
+
+template<>
+class NativeArgument<std::string> {
+ public:
+  void Convert(
+      JSContextRef context_ref,
+      JSValueRef value,
+      JSValueRef* exception) {
+    NativeStringView(context_ref, value, exception, &value_);
+  }
+
+  const std::string& Get() { return value_; }
+
+ private:
+  std::string value_;
+};
+
+template<>
+class NativeArgument<Handle<Value>> {
+ public:
+  void Convert(
+      JSContextRef context_ref,
+      JSValueRef value,
+      JSValueRef* exception) {
+    value_ = Value::New(context_ref, value);
+  }
+
+  const Handle<Value>& Get() { return value_; }
+
+ private:
+  Handle<Value> value_;
+};
+
+template<>
+struct NativeResult<double> {
+  static JSValueRef Make(JSContextRef context_ref, double r) {
+    return JSValueMakeNumber(context_ref, r);
+  }
+};
+
+template<>
+struct NativeResult<int32_t> {
+  static JSValueRef Make(JSContextRef context_ref, int32_t r) {
+    return JSValueMakeNumber(context_ref, r);
+  }
+};
+
+template<>
+struct NativeResult<uint32_t> {
+  static JSValueRef Make(JSContextRef context_ref, uint32_t r) {
+    return JSValueMakeNumber(context_ref, r);
+  }
+};
+
+template<>
+struct NativeResult<bool> {
+  static JSValueRef Make(JSContextRef context_ref, bool r) {
+    return JSValueMakeBoolean(context_ref, r);
+  }
+};
+
+template<>
+struct NativeResult<string_view> {
+  static JSValueRef Make(JSContextRef context_ref, string_view r) {
+    return MakeNativeString(context_ref, r);
+  }
+};
+
+template<>
+struct NativeResult<std::string> {
+  static JSValueRef Make(JSContextRef context_ref, const std::string& r) {
+    string_view view = { r.data(), r.size() };
+    return MakeNativeString(context_ref, view);
+  }
+};
+
+template<>
+struct NativeResult<Handle<Value>> {
+  static JSValueRef Make(JSContextRef context_ref, const Handle<Value>& r) {
+    return r->Extract();
+  }
+};
+
+template<typename R>
+struct NativeCall {
+  template<typename Function, typename... Arguments>
+  static JSValueRef Invoke(
+      JSContextRef context_ref,
+      JSValueRef* exception,
+      Function function,
+      Arguments&&... arguments) {
+    if (*exception != NULL) {
+      return JSValueMakeUndefined(context_ref);
+    }
+
+    return NativeResult<typename std::decay<R>::type>::Make(
+      context_ref, function(std::forward<Arguments>(arguments)...));
+  }
+};
+
+template<>
+struct NativeCall<void> {
+  template<typename Function, typename... Arguments>
+  static JSValueRef Invoke(
+      JSContextRef context_ref,
+      JSValueRef* exception,
+      Function function,
+      Arguments&&... arguments) {
+    if (*exception == NULL) {
+      function(std::forward<Arguments>(arguments)...);
+    }
+
+    return JSValueMakeUndefined(context_ref);
+  }
+};
+
+template<typename R, typename... Args, R (*function)(Args...)>
+class NativeBinding<R (*)(Args...), function> {
+ public:
+  static JSValueRef Callback(
+      JSContextRef context_ref,
+      JSObjectRef function_ref,
+      JSObjectRef this_ref,
+      size_t argument_count,
+      const JSValueRef* arguments_ref,
+      JSValueRef* exception_ref) {
+    CallArena::Scope arena_scope;
+
+    return Call(
+      context_ref,
+      argument_count,
+      arguments_ref,
+      exception_ref,
+      typename MakeNativeIndices<sizeof...(Args)>::Type());
+  }
+
+ private:
+  // The arguments are converted left to right, as scripts coerce them, in
+  // a braced list which orders the conversions. Once a conversion threw,
+  // the others convert undefined.
+  template<size_t... Indices>
+  static JSValueRef Call(
+      JSContextRef context_ref,
+      size_t argument_count,
+      const JSValueRef* arguments_ref,
+      JSValueRef* exception_ref,
+      NativeIndices<Indices...>) {
+    std::tuple<NativeArgument<typename std::decay<Args>::type>...> converted;
+    int expand[] = { 0, (std::get<Indices>(converted).Convert(
+      context_ref,
+      Indices < argument_count && *exception_ref == NULL ?
+        arguments_ref[Indices] :
+        JSValueMakeUndefined(context_ref),
+      exception_ref), 0)... };
+
+    (void) expand;
+
+    return NativeCall<R>::Invoke(
+      context_ref,
+      exception_ref,
+      function,
+      std::get<Indices>(converted).Get()...);
+  }
+};
+
+#endif
+
+// The engine callback of a native function, to be exported to scripts.
+template<typename Signature, Signature function>
+inline native_function Bind() {
+  return NativeBinding<Signature, function>::Callback;
+}
+
+}  // namespace bastian
+
+#endif  // BASTIAN_BIND_H_
@@ -0,0 +1,315 @@
+// Copyright David Corticchiato
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "./callsite.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "./runcontext.h"
+
+
+namespace bastian {
+
+// Argument slots kept from the start, more are added on demand and kept.
+static const size_t kReservedArguments = 8;
+
+// Calls sharing a handle scope in a batch.
+static const size_t kBatchScopeCalls = 256;
+
+Handle<Value> CallSite::Invoke(const std::vector<Handle<Value>>& arguments) {
+#ifdef BASTIAN_V8
+  v8::HandleScope handle_scope(isolate_);
+#endif
+
+  for (size_t index = 0; index < arguments.size(); ++index) {
+    Push(arguments[index]);
+  }
+
+  return Call();
+}
+
+void CallSite::InvokeBatch(
+    const std::vector<std::vector<Handle<Value>>>& calls,
+    std::vector<Handle<Value>>* results) {
+  size_t index = 0;
+
+  results->resize(calls.size());
+
+  while (index < calls.size()) {
+#ifdef BASTIAN_V8
+    v8::HandleScope handle_scope(isolate_);
+#endif
+    size_t end = std::min(calls.size(), index + kBatchScopeCalls);
+
+    for (; index < end; ++index) {
+      const std::vector<Handle<Value>>& arguments = calls[index];
+
+      for (size_t argument = 0; argument < arguments.size(); ++argument) {
+        Push(arguments[argument]);
+      }
+
+      (*results)[index] = Call();
+    }
+  }
+}
+
+void CallSite::InvokeColumns(
+    const std::vector<std::vector<double>>& columns,
+    std::vector<double>* results) {
+  size_t rows = columns.empty() ? 0 : columns[0].size();
+  size_t row = 0;
+
+  for (size_t column = 1; column < columns.size(); ++column) {
+    rows = std::min(rows, columns[column].size());
+  }
+
+  results->resize(rows);
+
+  while (row < rows) {
+#ifdef BASTIAN_V8
+    v8::HandleScope handle_scope(isolate_);
+#endif
+    size_t end = std::min(rows, row + kBatchScopeCalls);
+
+    for (; row < end; ++row) {
+      for (size_t column = 0; column < columns.size(); ++column) {
+        Push(columns[column][row]);
+      }
+
+      (*results)[row] = CallNumber();
+    }
+  }
+}
+
+
+//
+// V8 CallSite
+//
+
+
+#ifdef BASTIAN_V8
+
+CallSite::CallSite(const Handle<Value>& function)
+  : isolate_(v8::Isolate::GetCurrent()),
+    handle_scope_(isolate_) {
+  Prepare(function, Handle<Value>());
+}
+
+CallSite::CallSite(const Handle<Value>& function, const Handle<Value>& receiver)
+  : isolate_(v8::Isolate::GetCurrent()),
+    handle_scope_(isolate_) {
+  Prepare(function, receiver);
+}
+
+CallSite::~CallSite() {
+  if (!context_.IsEmpty()) {
+    context_->Exit();
+  }
+}
+
+void CallSite::Prepare(
+    const Handle<Value>& function,
+    const Handle<Value>& receiver) {
+  arguments_.reserve(kReservedArguments);
+
+  if (!function->IsFunction()) {
+    return;
+  }
+
+  function_ = v8::Local<v8::Function>::Cast(function->Extract());
+  context_ = function_->CreationContext();
+  context_->Enter();
+
+  if (Handle<Value>::Is(NULL, receiver)) {
+    receiver_ = context_->Global();
+  } else {
+    receiver_ = receiver->Extract();
+  }
+}
+
+void CallSite::Push(const Handle<Value>& argument) {
+  arguments_.push_back(argument->Extract());
+}
+
+void CallSite::Push(double argument) {
+  arguments_.push_back(v8::Number::New(isolate_, argument));
+}
+
+Handle<Value> CallSite::Call() {
+  Handle<Value> value = UndefinedValue::New();
+
+  if (!function_.IsEmpty()) {
+    // Caught on every call, when the site is used from a native function
+    // an exception would otherwise stay pending for the next calls.
+    v8::TryCatch try_catch;
+    v8::Local<v8::Value> result = function_->Call(
+      receiver_,
+      static_cast<int>(arguments_.size()),
+      arguments_.empty() ? NULL : &arguments_[0]);
+
+    if (!try_catch.HasCaught()) {
+      value = Value::New(result);
+    }
+  }
+
+  arguments_.clear();
+
+  return value;
+}
+
+double CallSite::CallNumber() {
+  double number = std::numeric_limits<double>::quiet_NaN();
+
+  if (!function_.IsEmpty()) {
+    v8::TryCatch try_catch;
+    v8::Local<v8::Value> result = function_->Call(
+      receiver_,
+      static_cast<int>(arguments_.size()),
+      arguments_.empty() ? NULL : &arguments_[0]);
+
+    if (!try_catch.HasCaught() && result->IsNumber()) {
+      number = result.As<v8::Number>()->Value();
+    }
+  }
+
+  arguments_.clear();
+
+  return number;
+}
+
+#endif
+
+
+//
+// JSC CallSite
+//
+
+
+#ifdef BASTIAN_JSC
+
+CallSite::CallSite(const Handle<Value>& function)
+  : context_(NULL),
+    function_(NULL),
+    receiver_(NULL) {
+  Prepare(function, Handle<Value>());
+}
+
+CallSite::CallSite(const Handle<Value>& function, const Handle<Value>& receiver)
+  : context_(NULL),
+    function_(NULL),
+    receiver_(NULL) {
+  Prepare(function, receiver);
+}
+
+CallSite::~CallSite() {
+  if (function_ != NULL) {
+    RunContext::SetCurrent(previous_context_);
+  }
+}
+
+// Host arguments and results are made in the function's own context, not
+// in whichever run was current last.
+void CallSite::Prepare(
+    const Handle<Value>& function,
+    const Handle<Value>& receiver) {
+  arguments_.reserve(kReservedArguments);
+
+  if (!function->IsFunction()) {
+    return;
+  }
+
+  Function* target = static_cast<Function*>(function.operator->());
+
+  context_ = target->jsc_context_;
+  function_ = target->jsc_object_;
+  previous_context_ = RunContext::GetCurrent();
+  RunContext::SetCurrent(RunContext::New(context_));
+
+  if (Handle<Value>::Is(NULL, receiver)) {
+    receiver_ = JSContextGetGlobalObject(context_);
+  } else {
+    receiver_ = JSValueToObject(context_, receiver->Extract(), NULL);
+  }
+}
+
+// Nothing is pushed without a function, there is no context to make the
+// arguments in.
+void CallSite::Push(const Handle<Value>& argument) {
+  if (function_ != NULL) {
+    arguments_.push_back(argument->Extract());
+  }
+}
+
+void CallSite::Push(double argument) {
+  if (function_ != NULL) {
+    arguments_.push_back(JSValueMakeNumber(context_, argument));
+  }
+}
+
+Handle<Value> CallSite::Call() {
+  Handle<Value> value = UndefinedValue::New();
+
+  if (function_ != NULL) {
+    JSValueRef exception = NULL;
+    JSValueRef result = JSObjectCallAsFunction(
+      context_,
+      function_,
+      receiver_,
+      arguments_.size(),
+      arguments_.empty() ? NULL : &arguments_[0],
+      &exception);
+
+    if (exception == NULL) {
+      value = Value::New(result);
+    }
+  }
+
+  arguments_.clear();
+
+  return value;
+}
+
+double CallSite::CallNumber() {
+  double number = std::numeric_limits<double>::quiet_NaN();
+
+  if (function_ != NULL) {
+    JSValueRef exception = NULL;
+    JSValueRef result = JSObjectCallAsFunction(
+      context_,
+      function_,
+      receiver_,
+      arguments_.size(),
+      arguments_.empty() ? NULL : &arguments_[0],
+      &exception);
+
+    if (exception == NULL && JSValueIsNumber(context_, result)) {
+      number = JSValueToNumber(context_, result, NULL);
+    }
+  }
+
+  arguments_.clear();
+
+  return number;
+}
+
+#endif
+
+}  // namespace bastian
@@ -0,0 +1,121 @@
+// Copyright David Corticchiato
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef BASTIAN_CALLSITE_H_
+#define BASTIAN_CALLSITE_H_
+
+#ifdef BASTIAN_V8
+#include <v8.h>
+#endif
+
+#ifdef BASTIAN_JSC
+#include <JavascriptCore/JavascriptCore.h>
+#endif
+
+#include <vector>
+
+#include "./handle.h"
+#include "./value.h"
+
+
+namespace bastian {
+
+class RunContext;
+
+// Calls the same script function many times. The function, the receiver
+// and the context are resolved once when the site is built, and the
+// argument buffer is reused across calls. A call then allocates nothing
+// for primitive arguments and results.
+//
+// Sites live on the stack. With V8 the site holds a handle scope, and it
+// stays in the function's context until it is destroyed. With JSC the
+// function's context is the current run context until then.
+class CallSite {
+ public:
+  // The receiver defaults to the global object of the function's context.
+  // Invoking a site built from a value which is not a function returns
+  // undefined.
+  explicit CallSite(const Handle<Value>& function);
+  CallSite(const Handle<Value>& function, const Handle<Value>& receiver);
+  ~CallSite();
+
+  // Arguments are values or numbers. Returns undefined when the function
+  // throws.
+  template<typename... Arguments>
+  Handle<Value> Invoke(const Arguments&... arguments) {
+#ifdef BASTIAN_V8
+    v8::HandleScope handle_scope(isolate_);
+#endif
+    int expand[] = { 0, (Push(arguments), 0)... };
+
+    (void) expand;
+
+    return Call();
+  }
+
+  Handle<Value> Invoke(const std::vector<Handle<Value>>& arguments);
+
+  // Calls the function once per argument list. results is resized to hold
+  // one result per call. Handle scopes are opened once per chunk of calls,
+  // not once per call.
+  void InvokeBatch(
+    const std::vector<std::vector<Handle<Value>>>& calls,
+    std::vector<Handle<Value>>* results);
+
+  // Calls the function once per row of numeric columns, with one argument
+  // per column, for as many rows as the shortest column has. Results which
+  // are not numbers are NaN. No value is allocated on either side.
+  void InvokeColumns(
+    const std::vector<std::vector<double>>& columns,
+    std::vector<double>* results);
+
+ private:
+  CallSite(const CallSite&);
+  CallSite& operator= (const CallSite&);
+
+  void Prepare(const Handle<Value>& function, const Handle<Value>& receiver);
+  void Push(const Handle<Value>& argument);
+  void Push(double argument);
+
+  // Calls with the pushed arguments and clears them.
+  Handle<Value> Call();
+  double CallNumber();
+
+#ifdef BASTIAN_V8
+  v8::Isolate* isolate_;
+  v8::HandleScope handle_scope_;
+  v8::Local<v8::Context> context_;
+  v8::Local<v8::Function> function_;
+  v8::Local<v8::Value> receiver_;
+  std::vector<v8::Local<v8::Value>> arguments_;
+#endif
+
+#ifdef BASTIAN_JSC
+  JSContextRef context_;
+  Handle<RunContext> previous_context_;
+  JSObjectRef function_;
+  JSObjectRef receiver_;
+  std::vector<JSValueRef> arguments_;
+#endif
+};
+
+}  // namespace bastian
+
+#endif  // BASTIAN_CALLSITE_H_
@@ -0,0 +1,245 @@
+// Copyright David Corticchiato
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "./codecache.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef BASTIAN_V8
+#include <v8.h>
+#endif
+
+
+namespace bastian {
+
+typedef struct t_code_cache_header {
+  uint32_t magic;
+  uint32_t source_length;
+  uint32_t source_check;
+  uint32_t data_length;
+  uint64_t fingerprint;
+  uint64_t data_check;
+} code_cache_header;
+
+static const uint32_t kCodeCacheMagic = 0x43545342;  // "BSTC"
+
+#ifdef BASTIAN_V8
+// Generated from the snapshot by tools/snapshot_fingerprint.py.
+extern const char kSnapshotFingerprint[];
+#endif
+
+// Zero until Setup, the code cache is then disabled.
+static uint64_t fingerprint = 0;
+
+static void Fingerprint(uint64_t* hash, const char * data) {
+  // FNV-1a, the terminating zero separates the parts.
+  do {
+    *hash ^= static_cast<unsigned char>(*data);
+    *hash *= 1099511628211ULL;
+  } while (*data++ != '\0');
+}
+
+// Independent from the hash used in file names, a hash collision on the
+// file name must not hand the code of another script to the engine.
+static uint32_t SourceCheck(const char * source, size_t length) {
+  uint32_t check = 0;
+
+  for (size_t index = 0; index < length; ++index) {
+    check = check * 31 + static_cast<unsigned char>(source[index]);
+  }
+
+  return check;
+}
+
+// The engine aborts on a malformed blob rather than rejecting it, a blob
+// damaged on disk is caught here and compiled again from the source.
+static uint64_t DataCheck(const uint8_t* data, size_t length) {
+  uint64_t check = 14695981039346656037ULL;
+
+  for (size_t index = 0; index < length; ++index) {
+    check ^= data[index];
+    check *= 1099511628211ULL;
+  }
+
+  return check;
+}
+
+static bool WriteAll(int fd, const void* data, size_t length) {
+  const char* cursor = static_cast<const char*>(data);
+
+  while (length > 0) {
+    ssize_t written = write(fd, cursor, length);
+
+    if (written <= 0) {
+      return false;
+    }
+
+    cursor += written;
+    length -= written;
+  }
+
+  return true;
+}
+
+
+//
+// Common CodeCache
+//
+
+
+void CodeCache::Setup(const std::string& flags) {
+#ifdef BASTIAN_V8
+  uint64_t hash = 14695981039346656037ULL;
+
+  // Serialization of top level code is off by default in this V8.
+  static const char flag[] = "--serialize-toplevel";
+  v8::V8::SetFlagsFromString(flag, sizeof(flag) - 1);
+
+  Fingerprint(&hash, v8::V8::GetVersion());
+  Fingerprint(&hash, kSnapshotFingerprint);
+  Fingerprint(&hash, flags.c_str());
+
+  // Zero is kept for a disabled cache.
+  fingerprint = hash != 0 ? hash : 1;
+#endif
+}
+
+CodeCache::CodeCache(const std::string& directory) : directory_(directory) {
+  if (Enabled()) {
+    mkdir(directory_.c_str(), 0755);
+  }
+}
+
+bool CodeCache::Enabled() {
+  return fingerprint != 0 && !directory_.empty();
+}
+
+std::string CodeCache::Path(size_t hash) {
+  char name[48];
+
+  std::snprintf(name, sizeof(name), "%016llx-%016llx.code",
+                static_cast<unsigned long long>(hash),
+                static_cast<unsigned long long>(fingerprint));
+
+  return directory_ + "/" + name;
+}
+
+bool CodeCache::Load(
+    size_t hash,
+    const char * source,
+    size_t length,
+    code_cache_blob* blob) {
+  int fd = open(Path(hash).c_str(), O_RDONLY);
+  struct stat info;
+
+  if (fd < 0) {
+    return false;
+  }
+
+  if (fstat(fd, &info) != 0
+      || static_cast<size_t>(info.st_size) < sizeof(code_cache_header)) {
+    close(fd);
+    return false;
+  }
+
+  void* mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+
+  blob->mapping = mapping;
+  blob->mapping_length = info.st_size;
+
+  const code_cache_header* header =
+    static_cast<const code_cache_header*>(mapping);
+
+  if (header->magic != kCodeCacheMagic
+      || header->fingerprint != fingerprint
+      || header->source_length != length
+      || header->source_check != SourceCheck(source, length)
+      || header->data_length + sizeof(code_cache_header) != blob->mapping_length) {
+    Release(blob);
+    return false;
+  }
+
+  blob->data = static_cast<const uint8_t*>(mapping) + sizeof(code_cache_header);
+  blob->length = header->data_length;
+
+  if (header->data_check != DataCheck(blob->data, blob->length)) {
+    Release(blob);
+    return false;
+  }
+
+  return true;
+}
+
+void CodeCache::Release(code_cache_blob* blob) {
+  munmap(blob->mapping, blob->mapping_length);
+  blob->mapping = NULL;
+  blob->data = NULL;
+}
+
+bool CodeCache::Store(
+    size_t hash,
+    const char * source,
+    size_t length,
+    const uint8_t* data,
+    size_t data_length) {
+  std::string path = Path(hash);
+  std::string temp_path = path + ".XXXXXX";
+  code_cache_header header;
+
+  header.magic = kCodeCacheMagic;
+  header.source_length = static_cast<uint32_t>(length);
+  header.source_check = SourceCheck(source, length);
+  header.data_length = static_cast<uint32_t>(data_length);
+  header.fingerprint = fingerprint;
+  header.data_check = DataCheck(data, data_length);
+
+  // Written aside then renamed, a concurrent Load never maps a partial blob.
+  int fd = mkstemp(&temp_path[0]);
+
+  if (fd < 0) {
+    return false;
+  }
+
+  bool written = WriteAll(fd, &header, sizeof(header))
+    && WriteAll(fd, data, data_length);
+
+  close(fd);
+
+  if (!written || rename(temp_path.c_str(), path.c_str()) != 0) {
+    unlink(temp_path.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+}  // namespace bastian
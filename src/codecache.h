@@ -0,0 +1,71 @@
+// Copyright David Corticchiato
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef BASTIAN_CODECACHE_H_
+#define BASTIAN_CODECACHE_H_
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+
+
+namespace bastian {
+
+typedef struct t_code_cache_blob {
+  const uint8_t* data;
+  size_t length;
+  void* mapping;
+  size_t mapping_length;
+} code_cache_blob;
+
+// Code cache blobs produced by the engine, stored one file per script in a
+// directory and memory-mapped back on later runs. File names carry the
+// source hash and a fingerprint of the engine version, the startup
+// snapshot, the build configuration and the flags given to Init. Blobs of
+// another fingerprint are never read: the engine loads them without any
+// check of its own.
+class CodeCache {
+ public:
+  // Called by Init before the engine starts, code caches stay disabled
+  // otherwise. Turns on the serialization of top level code.
+  static void Setup(const std::string& flags);
+
+  explicit CodeCache(const std::string& directory);
+  bool Enabled();
+
+  // Maps the blob stored for the given source, returns false when there is
+  // none, when it was produced for a different source or when its bytes do
+  // not match their checksum.
+  bool Load(size_t hash, const char * source, size_t length,
+            code_cache_blob* blob);
+  void Release(code_cache_blob* blob);
+  bool Store(size_t hash, const char * source, size_t length,
+             const uint8_t* data, size_t data_length);
+
+ private:
+  std::string Path(size_t hash);
+
+  std::string directory_;
+};
+
+}  // namespace bastian
+
+#endif  // BASTIAN_CODECACHE_H_
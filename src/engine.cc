@@ -19,12 +19,28 @@
 // OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "./engine.h"
+#include "./platform.h"
 
 #include "./runcontext.h"
+#include <cstring>
 #include <iostream>
 
 namespace bastian {
 
+//
+// Common Engine
+//
+
+
+EngineOptions::EngineOptions() {
+  script_cache_bytes = 16 * 1024 * 1024;
+  context_pool_size = 0;
+  context_policy = CONTEXT_DISCARD;
+#ifdef BASTIAN_V8
+  isolate = NULL;
+#endif
+}
+
 //
 // V8 Engine
 //
@@ -32,41 +48,364 @@ namespace bastian {
 
 #ifdef BASTIAN_V8
 
-static v8::Isolate* isolate = v8::Isolate::New();
-static v8::Isolate::Scope isolatescope(isolate);
-static v8::HandleScope handle_scope(isolate);
+// Isolate shared by the engines of a thread built without one, it stays
+// entered until the last of them is disposed.
+static thread_local v8::Isolate* thread_isolate = NULL;
+static thread_local int thread_isolate_engines = 0;
 
 Handle<Engine> Engine::New(v8_obj_generator obj_generator) {
-  V8Engine* engine = new V8Engine(obj_generator);
+  return New(obj_generator, EngineOptions());
+}
+
+Handle<Engine> Engine::New(
+    v8_obj_generator obj_generator,
+    const EngineOptions& options) {
+  V8Engine* engine = new V8Engine(obj_generator, options);
   Handle<Engine> handle(reinterpret_cast<Engine*>(engine));
 
   return handle;
 }
 
-V8Engine::V8Engine(v8_obj_generator obj_generator) {
+V8Engine::V8Engine(
+    v8_obj_generator obj_generator,
+    const EngineOptions& options)
+  : script_cache_(options.script_cache_bytes, options.code_cache_dir) {
   obj_generator_ = obj_generator;
+  context_pool_size_ = options.context_pool_size;
+  context_policy_ = options.context_policy;
+  disposed_ = false;
+  isolate_ = options.isolate;
+  owns_isolate_ = isolate_ == NULL;
+
+  if (owns_isolate_) {
+    if (thread_isolate == NULL) {
+      thread_isolate = NewIsolate();
+      thread_isolate->Enter();
+    }
+
+    isolate_ = thread_isolate;
+    ++thread_isolate_engines;
+  }
+}
+
+V8Engine::~V8Engine() {
+  Dispose();
+}
+
+void V8Engine::Dispose() {
+  if (disposed_) {
+    return;
+  }
+
+  {
+    v8::Isolate::Scope isolate_scope(isolate_);
+
+    ClearContextPool();
+    script_cache_.Clear();
+    global_template_.Reset();
+    compile_context_.Reset();
+  }
+
+  disposed_ = true;
+
+  if (owns_isolate_ && --thread_isolate_engines == 0) {
+    RunContext::SetCurrent(Handle<RunContext>());
+    isolate_->Exit();
+    DisposeIsolate(isolate_);
+    thread_isolate = NULL;
+  }
 }
 
 Handle<Value> V8Engine::Run(const char * raw_source) {
-  v8::Local<v8::Context> pre_context = v8::Context::New(v8::Isolate::GetCurrent());
-  v8::Context::Scope pre_context_scope(pre_context);
+  return Run(Compile(raw_source));
+}
 
-  Handle<V8ObjectContext> global = V8ObjectContext::New();
+Handle<Value> V8Engine::Run(Handle<Script> script) {
+  v8::Isolate* isolate = isolate_;
 
-  obj_generator_(global);
+  if (!script->IsValid()) {
+    return NullValue::New();
+  }
 
-  v8::Local<v8::Context> context = v8::Context::New(
-    v8::Isolate::GetCurrent(), NULL, global->ObjectTemplate());
+  v8::Isolate::Scope isolate_scope(isolate);
+  v8::HandleScope handle_scope(isolate);
 
-  bastian::RunContext::SetCurrent(bastian::RunContext::New(context));
+  // Engines outside of a pool are never pumped otherwise.
+  while (PumpMessageLoop()) {}
+  IsolateHandles::ReleaseDropped(isolate);
+
+  v8::Local<v8::Context> context = NewContext();
+  v8::Context::Scope context_scope(context);
+  v8::Local<v8::UnboundScript> unbound_script =
+    script->v8_script_.Get(isolate);
+
+  v8::Local<v8::Value> result = unbound_script->BindToCurrentContext()->Run();
+  Handle<Value> value = Value::New(result);
+
+  ReleaseContext(context);
+
+  return value;
+}
+
+Handle<Value> V8Engine::Run(
+    Handle<Script> script,
+    const std::vector<Handle<Value>>& arguments) {
+  v8::Isolate::Scope isolate_scope(isolate_);
+  v8::HandleScope handle_scope(isolate_);
+
+  while (PumpMessageLoop()) {}
+  IsolateHandles::ReleaseDropped(isolate_);
+
+  v8::Local<v8::UnboundScript> function_script = FunctionScript(script);
+
+  if (function_script.IsEmpty()) {
+    return NullValue::New();
+  }
+
+  v8::Local<v8::Context> context = NewContext();
   v8::Context::Scope context_scope(context);
-  v8::Local<v8::String> source = v8::String::NewFromUtf8(
-    v8::Isolate::GetCurrent(), raw_source);
-  v8::Local<v8::Script> script = v8::Script::Compile(source);
+  v8::Local<v8::Function> function = v8::Local<v8::Function>::Cast(
+    function_script->BindToCurrentContext()->Run());
+  std::vector<v8::Local<v8::Value>> args(arguments.size());
+
+  for (unsigned index = 0; index < arguments.size(); ++index) {
+    args[index] = arguments.at(index)->Extract();
+  }
+
+  v8::Local<v8::Value> result = function->Call(
+    context->Global(),
+    static_cast<int>(args.size()),
+    args.empty() ? NULL : &args[0]);
+  Handle<Value> value = Value::New(result);
+
+  ReleaseContext(context);
+
+  return value;
+}
+
+Handle<Script> V8Engine::Compile(const char * raw_source, const char * name) {
+  v8::Isolate* isolate = isolate_;
+  v8::Isolate::Scope isolate_scope(isolate);
+  v8::HandleScope handle_scope(isolate);
+  v8::Context::Scope context_scope(CompileContext());
+
+  return Script::New(
+    script_cache_.Get(name, raw_source, std::strlen(raw_source)),
+    raw_source,
+    name);
+}
+
+v8::Local<v8::Context> V8Engine::NewContext() {
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::Local<v8::Context> context;
+
+  if (context_pool_.empty()) {
+    context = CreateContext();
+  } else {
+    v8::Persistent<v8::Context>* pooled = context_pool_.front();
+    context_pool_.pop_front();
+    context = v8::Local<v8::Context>::New(isolate, *pooled);
+    pooled->Reset();
+    delete pooled;
+  }
+
+  bastian::RunContext::SetCurrent(bastian::RunContext::New(context));
+
+  return context;
+}
+
+void V8Engine::ReleaseContext(v8::Local<v8::Context> context) {
+  if (context_policy_ != EngineOptions::CONTEXT_RESET
+      || context_pool_.size() >= context_pool_size_) {
+    return;
+  }
+
+  ResetContext(context);
+  context_pool_.push_back(new v8::Persistent<v8::Context>(
+    v8::Isolate::GetCurrent(), context));
+}
+
+// Name of the hidden value holding the pristine globals of a context.
+static v8::Local<v8::String> PristineKey(v8::Isolate* isolate) {
+  return v8::String::NewFromUtf8(isolate, "bastian::pristine");
+}
+
+static v8::Local<v8::String> Name(v8::Isolate* isolate, const char * name) {
+  return v8::String::NewFromUtf8(isolate, name);
+}
+
+// The properties live on the global object behind the global proxy.
+static v8::Local<v8::Object> GlobalObject(v8::Local<v8::Context> context) {
+  return context->Global()->GetPrototype().As<v8::Object>();
+}
+
+// All own names, GetOwnPropertyNames leaves out the non enumerable ones
+// such as the built-in constructors.
+static v8::Local<v8::Array> OwnNames(
+    v8::Local<v8::Function> own_names,
+    v8::Local<v8::Object> object) {
+  v8::Local<v8::Value> argument = object;
+  return own_names->Call(object, 1, &argument).As<v8::Array>();
+}
+
+// Contexts meant to be reset keep a copy of their own globals, taken
+// before any script ran in them, along with the Object.getOwnPropertyNames
+// of the context which a script could overwrite.
+v8::Local<v8::Context> V8Engine::CreateContext() {
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::EscapableHandleScope handle_scope(isolate);
+  v8::Local<v8::Context> context =
+    v8::Context::New(isolate, NULL, GlobalTemplate());
+
+  if (context_policy_ == EngineOptions::CONTEXT_RESET
+      && context_pool_size_ > 0) {
+    v8::Context::Scope context_scope(context);
+    v8::Local<v8::Object> global = GlobalObject(context);
+    v8::Local<v8::Function> own_names = global->Get(Name(isolate, "Object"))
+      .As<v8::Object>()->Get(Name(isolate, "getOwnPropertyNames"))
+      .As<v8::Function>();
+    v8::Local<v8::Array> names = OwnNames(own_names, global);
+    v8::Local<v8::Object> values = v8::Object::New(isolate);
+    v8::Local<v8::Object> attributes = v8::Object::New(isolate);
+    v8::Local<v8::Object> pristine = v8::Object::New(isolate);
+
+    values->SetPrototype(v8::Null(isolate));
+    attributes->SetPrototype(v8::Null(isolate));
+
+    for (uint32_t index = 0; index < names->Length(); ++index) {
+      v8::Local<v8::Value> name = names->Get(index);
+
+      values->Set(name, global->Get(name));
+      attributes->Set(name, v8::Integer::New(
+        isolate, global->GetPropertyAttributes(name)));
+    }
+
+    pristine->Set(Name(isolate, "names"), own_names);
+    pristine->Set(Name(isolate, "values"), values);
+    pristine->Set(Name(isolate, "attributes"), attributes);
+    global->SetHiddenValue(PristineKey(isolate), pristine);
+  }
+
+  return handle_scope.Escape(context);
+}
+
+// Globals added by the run are deleted, those declared with var cannot be
+// and are set to undefined. Pristine globals the run changed or deleted
+// get their value back. Changes made inside the objects they hold, such as
+// a new property on Array.prototype, survive.
+void V8Engine::ResetContext(v8::Local<v8::Context> context) {
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::HandleScope handle_scope(isolate);
+  v8::Local<v8::Object> global = GlobalObject(context);
+  v8::Local<v8::Value> hidden = global->GetHiddenValue(PristineKey(isolate));
+
+  if (hidden.IsEmpty() || !hidden->IsObject()) {
+    return;
+  }
+
+  v8::Local<v8::Object> pristine = hidden.As<v8::Object>();
+  v8::Local<v8::Function> own_names =
+    pristine->Get(Name(isolate, "names")).As<v8::Function>();
+  v8::Local<v8::Object> values =
+    pristine->Get(Name(isolate, "values")).As<v8::Object>();
+  v8::Local<v8::Object> attributes =
+    pristine->Get(Name(isolate, "attributes")).As<v8::Object>();
+  v8::Local<v8::Array> names = OwnNames(own_names, global);
+
+  for (uint32_t index = 0; index < names->Length(); ++index) {
+    v8::Local<v8::String> name = names->Get(index)->ToString();
+
+    if (!values->HasOwnProperty(name) && !global->Delete(name)) {
+      global->Set(name, v8::Undefined(isolate));
+    }
+  }
+
+  names = OwnNames(own_names, values);
+
+  for (uint32_t index = 0; index < names->Length(); ++index) {
+    v8::Local<v8::String> name = names->Get(index)->ToString();
+    v8::Local<v8::Value> value = values->Get(name);
+
+    if (!global->HasOwnProperty(name)
+        || !global->Get(name)->StrictEquals(value)) {
+      global->ForceSet(name, value, static_cast<v8::PropertyAttribute>(
+        attributes->Get(name)->Int32Value()));
+    }
+  }
+}
+
+bool V8Engine::FillContextPool() {
+  v8::Isolate* isolate = isolate_;
+
+  if (context_pool_.size() >= context_pool_size_) {
+    return false;
+  }
+
+  v8::Isolate::Scope isolate_scope(isolate);
+  v8::HandleScope handle_scope(isolate);
+
+  context_pool_.push_back(new v8::Persistent<v8::Context>(
+    isolate, CreateContext()));
+
+  return true;
+}
 
-  v8::Local<v8::Value> result = script->Run();
+void V8Engine::ClearContextPool() {
+  while (!context_pool_.empty()) {
+    context_pool_.front()->Reset();
+    delete context_pool_.front();
+    context_pool_.pop_front();
+  }
+}
+
+v8::Local<v8::UnboundScript> V8Engine::FunctionScript(Handle<Script> script) {
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+
+  if (script->v8_function_.IsEmpty()) {
+    v8::HandleScope handle_scope(isolate);
+    v8::Context::Scope context_scope(CompileContext());
+    script->v8_function_.Reset(isolate, script_cache_.GetFunction(
+      script->name_.c_str(), script->source_.data(), script->source_.size()));
+  }
+
+  return script->v8_function_.Get(isolate);
+}
+
+script_cache_stats V8Engine::ScriptCacheStats() {
+  return script_cache_.Stats();
+}
+
+void V8Engine::Rebuild() {
+  global_template_.Reset();
+  ClearContextPool();
+}
+
+v8::Local<v8::ObjectTemplate> V8Engine::GlobalTemplate() {
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+
+  if (global_template_.IsEmpty()) {
+    v8::HandleScope handle_scope(isolate);
+    v8::Context::Scope compile_context_scope(CompileContext());
+
+    Handle<V8ObjectContext> global = V8ObjectContext::New();
+
+    obj_generator_(global);
+    global_template_.Reset(isolate, global->ObjectTemplate());
+  }
+
+  return v8::Local<v8::ObjectTemplate>::New(isolate, global_template_);
+}
+
+// Compiling and building the exported API both need an entered context,
+// none of the scripts run in this one.
+v8::Local<v8::Context> V8Engine::CompileContext() {
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+
+  if (compile_context_.IsEmpty()) {
+    compile_context_.Reset(isolate, v8::Context::New(isolate));
+  }
 
-  return Value::New(result);
+  return v8::Local<v8::Context>::New(isolate, compile_context_);
 }
 
 #endif
@@ -79,19 +418,122 @@ Handle<Value> V8Engine::Run(const char * raw_source) {
 #ifdef BASTIAN_JSC
 
 Handle<Engine> Engine::New(jsc_obj_generator obj_generator) {
-  JSCEngine* engine = new JSCEngine(obj_generator);
+  return New(obj_generator, EngineOptions());
+}
+
+Handle<Engine> Engine::New(
+    jsc_obj_generator obj_generator,
+    const EngineOptions& options) {
+  JSCEngine* engine = new JSCEngine(obj_generator, options);
   Handle<Engine> handle(reinterpret_cast<Engine*>(engine));
 
   return handle;
 }
 
-JSCEngine::JSCEngine(jsc_obj_generator obj_generator) {
+JSCEngine::JSCEngine(
+    jsc_obj_generator obj_generator,
+    const EngineOptions& options)
+  : script_cache_(options.script_cache_bytes, options.code_cache_dir) {
   obj_generator_ = obj_generator;
+  globals_class_ = JSClassCreate(&JSCObjectContext::void_class_def_);
+  compile_context_ = NULL;
+  context_pool_size_ = options.context_pool_size;
+}
+
+JSCEngine::~JSCEngine() {
+  Dispose();
+}
+
+void JSCEngine::Dispose() {
+  if (globals_class_ == NULL) {
+    return;
+  }
+
+  ClearContextPool();
+  script_cache_.Clear();
+
+  if (compile_context_ != NULL) {
+    JSGlobalContextRelease(compile_context_);
+    compile_context_ = NULL;
+  }
+
+  JSClassRelease(globals_class_);
+  globals_class_ = NULL;
 }
 
 Handle<Value> JSCEngine::Run(const char * raw_source) {
-  JSClassRef globals = JSClassCreate(&JSCObjectContext::void_class_def_);
-  JSContextRef ctx = JSGlobalContextCreate(globals);
+  return Run(Compile(raw_source));
+}
+
+Handle<Value> JSCEngine::Run(Handle<Script> script) {
+  if (!script->IsValid()) {
+    return NullValue::New();
+  }
+
+  JSGlobalContextRef ctx = NewContext();
+  JSValueRef exception = NULL;
+  JSValueRef result = JSEvaluateScript(
+    ctx, script->jsc_source_, NULL, script->jsc_name_, 1, &exception);
+  Handle<Value> value = Value::New(result);
+
+  // The run context holds its own reference for the values bound to it.
+  JSGlobalContextRelease(ctx);
+
+  return value;
+}
+
+Handle<Value> JSCEngine::Run(
+    Handle<Script> script,
+    const std::vector<Handle<Value>>& arguments) {
+  // Contexts are never reused, the function is made once in the context
+  // it runs in. JSC checks that the body does not close it early.
+  JSGlobalContextRef ctx = NewContext();
+  JSValueRef exception = NULL;
+  JSObjectRef function = JSObjectMakeFunction(
+    ctx, NULL, 0, NULL, script->jsc_source_, script->jsc_name_, 1, &exception);
+  Handle<Value> value = NullValue::New();
+
+  if (function != NULL) {
+    std::vector<JSValueRef> args(arguments.size());
+
+    for (unsigned index = 0; index < arguments.size(); ++index) {
+      args[index] = arguments.at(index)->Extract();
+    }
+
+    JSValueRef result = JSObjectCallAsFunction(
+      ctx,
+      function,
+      NULL,
+      args.size(),
+      args.empty() ? NULL : &args[0],
+      &exception);
+
+    if (result != NULL) {
+      value = Value::New(result);
+    }
+  }
+
+  JSGlobalContextRelease(ctx);
+
+  return value;
+}
+
+JSGlobalContextRef JSCEngine::NewContext() {
+  JSGlobalContextRef ctx;
+
+  if (context_pool_.empty()) {
+    return CreateContext();
+  }
+
+  ctx = context_pool_.front();
+  context_pool_.pop_front();
+  bastian::RunContext::SetCurrent(bastian::RunContext::New(ctx));
+
+  return ctx;
+}
+
+JSGlobalContextRef JSCEngine::CreateContext() {
+  JSGlobalContextRef ctx = JSGlobalContextCreate(globals_class_);
 
   bastian::RunContext::SetCurrent(bastian::RunContext::New(ctx));
 
@@ -100,14 +542,56 @@ Handle<Value> JSCEngine::Run(const char * raw_source) {
 
   obj_generator_(new_object_ctx);
 
- 
   new_object_ctx->object_ref_ = global_object;
   new_object_ctx->Patch();
-  JSStringRef script = JSStringCreateWithUTF8CString(raw_source);
-  JSValueRef exception = NULL;
-  JSValueRef result = JSEvaluateScript(ctx, script, NULL, NULL, 1, &exception);
 
-  return Value::New(result);
+  return ctx;
+}
+
+Handle<Script> JSCEngine::Compile(const char * raw_source, const char * name) {
+  JSStringRef source = script_cache_.Get(
+    name, raw_source, std::strlen(raw_source));
+  JSStringRef name_string = NULL;
+
+  if (compile_context_ == NULL) {
+    compile_context_ = JSGlobalContextCreate(NULL);
+  }
+
+  if (name != NULL) {
+    name_string = JSStringCreateWithUTF8CString(name);
+  }
+
+  bool valid = JSCheckScriptSyntax(
+    compile_context_, source, name_string, 1, NULL);
+
+  return Script::New(source, name_string, valid);
+}
+
+script_cache_stats JSCEngine::ScriptCacheStats() {
+  return script_cache_.Stats();
+}
+
+bool JSCEngine::FillContextPool() {
+  if (context_pool_.size() >= context_pool_size_) {
+    return false;
+  }
+
+  context_pool_.push_back(CreateContext());
+
+  return true;
+}
+
+void JSCEngine::ClearContextPool() {
+  while (!context_pool_.empty()) {
+    JSGlobalContextRelease(context_pool_.front());
+    context_pool_.pop_front();
+  }
+}
+
+void JSCEngine::Rebuild() {
+  // Exports are patched onto each new global object, there is no
+  // template to invalidate, only pooled contexts to drop.
+  ClearContextPool();
 }
 
 #endif
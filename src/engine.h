@@ -29,22 +29,99 @@
 #include <JavascriptCore/JavascriptCore.h>
 #endif
 
+#include <deque>
+#include <string>
+#include <vector>
+
 #include "./handle.h"
 #include "./objcontext.h"
+#include "./script.h"
+#include "./scriptcache.h"
 
 
 namespace bastian {
 
-class Engine {
+struct EngineOptions {
+  enum ContextPolicy {
+    CONTEXT_DISCARD,
+    CONTEXT_RESET
+  };
+
+  EngineOptions();
+
+  // Budget of the compiled script cache, in source bytes.
+  size_t script_cache_bytes;
+
+  // Directory of the on-disk code cache, disabled when empty. Only used by
+  // the V8 engine, once InitOptions::code_cache enabled it.
+  std::string code_cache_dir;
+
+  // Number of ready-made contexts kept by the engine, 0 disables the pool.
+  size_t context_pool_size;
+
+  // What becomes of a pooled context once a run is done. CONTEXT_DISCARD
+  // drops it and every run gets a pristine context. CONTEXT_RESET deletes
+  // the globals added by the run, gives the globals it overwrote their
+  // first value back and puts the context back in the pool. Changes made
+  // inside built-in objects, such as a new property on Array.prototype,
+  // survive. JSC always discards.
+  ContextPolicy context_policy;
+
+#ifdef BASTIAN_V8
+  // Isolate the engine runs in, entered by the caller, who disposes it with
+  // DisposeIsolate. When NULL the engines of a thread share an isolate
+  // created with the first of them and disposed with the last.
+  v8::Isolate* isolate;
+#endif
+};
+
+class Engine : public RefCounted {
  public:
+  virtual ~Engine() {}
+
+  // Compiles the source once, the returned script can be run many times.
+  // The name is used as the script origin and is part of the cache key.
+  // Compile errors are not reported, the script is then not valid.
+  virtual Handle<Script> Compile(
+      const char * source,
+      const char * name = NULL) = 0;
+  virtual Handle<Value> Run(Handle<Script> script) = 0;
   virtual Handle<Value> Run(const char *) = 0;
 
+  // Runs the script as the body of a function called with the arguments,
+  // the body is compiled once whatever the arguments. A body which does
+  // not parse as a function on its own returns null without running.
+  virtual Handle<Value> Run(
+      Handle<Script> script,
+      const std::vector<Handle<Value>>& arguments) = 0;
+  virtual script_cache_stats ScriptCacheStats() = 0;
+
+  // Adds one context to the pool, returns false when it is already full.
+  // Meant to be called on the engine thread while it is idle.
+  virtual bool FillContextPool() = 0;
+
+  // Drops the cached global template so that the next Run calls the
+  // object generator again. Only needed when the exported API changes.
+  virtual void Rebuild() = 0;
+
+  // Frees the contexts, templates and compiled scripts of the engine, and
+  // the isolate once no other engine of the thread uses it. The engine can
+  // not be run afterwards, values and scripts it returned can still be
+  // dropped. Called by the destructor.
+  virtual void Dispose() = 0;
+
 #ifdef BASTIAN_V8
   static Handle<Engine> New(v8_obj_generator obj_generator);
+  static Handle<Engine> New(
+    v8_obj_generator obj_generator,
+    const EngineOptions& options);
 #endif
 
 #ifdef BASTIAN_JSC
   static Handle<Engine> New(jsc_obj_generator obj_generator);
+  static Handle<Engine> New(
+    jsc_obj_generator obj_generator,
+    const EngineOptions& options);
 #endif
 };
 
@@ -57,11 +134,39 @@ class Engine {
 
 class V8Engine : Engine {
  public:
-  explicit V8Engine(v8_obj_generator);
+  V8Engine(v8_obj_generator, const EngineOptions&);
+  ~V8Engine();
+  Handle<Script> Compile(const char * source, const char * name = NULL);
+  Handle<Value> Run(Handle<Script> script);
   Handle<Value> Run(const char *);
+  Handle<Value> Run(
+      Handle<Script> script,
+      const std::vector<Handle<Value>>& arguments);
+  script_cache_stats ScriptCacheStats();
+  bool FillContextPool();
+  void Rebuild();
+  void Dispose();
 
  private:
+  v8::Local<v8::Context> NewContext();
+  v8::Local<v8::Context> CreateContext();
+  void ReleaseContext(v8::Local<v8::Context> context);
+  void ResetContext(v8::Local<v8::Context> context);
+  void ClearContextPool();
+  v8::Local<v8::UnboundScript> FunctionScript(Handle<Script> script);
+  v8::Local<v8::ObjectTemplate> GlobalTemplate();
+  v8::Local<v8::Context> CompileContext();
+
   v8_obj_generator obj_generator_;
+  v8::Isolate* isolate_;
+  bool owns_isolate_;
+  bool disposed_;
+  v8::Persistent<v8::ObjectTemplate> global_template_;
+  v8::Persistent<v8::Context> compile_context_;
+  ScriptCache script_cache_;
+  std::deque<v8::Persistent<v8::Context>*> context_pool_;
+  size_t context_pool_size_;
+  EngineOptions::ContextPolicy context_policy_;
 };
 #endif
 
@@ -74,11 +179,30 @@ class V8Engine : Engine {
 
 class JSCEngine : Engine {
  public:
-  explicit JSCEngine(jsc_obj_generator);
+  JSCEngine(jsc_obj_generator, const EngineOptions&);
+  ~JSCEngine();
+  Handle<Script> Compile(const char * source, const char * name = NULL);
+  Handle<Value> Run(Handle<Script> script);
   Handle<Value> Run(const char *);
+  Handle<Value> Run(
+      Handle<Script> script,
+      const std::vector<Handle<Value>>& arguments);
+  script_cache_stats ScriptCacheStats();
+  bool FillContextPool();
+  void Rebuild();
+  void Dispose();
 
  private:
+  JSGlobalContextRef NewContext();
+  JSGlobalContextRef CreateContext();
+  void ClearContextPool();
+
   jsc_obj_generator obj_generator_;
+  JSClassRef globals_class_;
+  JSGlobalContextRef compile_context_;
+  ScriptCache script_cache_;
+  std::deque<JSGlobalContextRef> context_pool_;
+  size_t context_pool_size_;
 };
 
 
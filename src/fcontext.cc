@@ -19,45 +19,155 @@
 // OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include <cstddef>
+#include <limits>
+#include <new>
 
+#include "./bind.h"
 #include "./fcontext.h"
 
 
 namespace bastian {
 
+ArgumentMemo* NewArgumentMemos(int count) {
+  ArgumentMemo* arguments = static_cast<ArgumentMemo*>(
+    CallArena::Allocate(count * sizeof(ArgumentMemo)));
+
+  for (int index = 0; index < count; ++index) {
+    ArgumentMemo* argument = new (&arguments[index]) ArgumentMemo();
+
+    argument->view.data = NULL;
+    argument->view.length = 0;
+    argument->buffer = NULL;
+  }
+
+  return arguments;
+}
+
+void DeleteArgumentMemos(ArgumentMemo* arguments, int count) {
+  for (int index = 0; index < count; ++index) {
+    CallArena::Free(arguments[index].buffer);
+    arguments[index].~ArgumentMemo();
+  }
+
+  CallArena::Free(arguments);
+}
+
+// ToString of a missing argument.
+static string_view UndefinedView() {
+  string_view view = { "undefined", 9 };
+  return view;
+}
+
 //
 // V8 Function Context
 //
 
 #ifdef BASTIAN_V8
 
-V8FunctionContext::V8FunctionContext(
-  const v8::FunctionCallbackInfo<v8::Value>& infos) {
-  infos_ = &infos;
+ArgumentMemo* V8FunctionContext::Memo(int index) {
+  if (index < 0 || index >= infos_.Length()) {
+    return NULL;
+  }
+
+  if (arguments_ == NULL) {
+    arguments_ = NewArgumentMemos(infos_.Length());
+  }
+
+  return &arguments_[index];
 }
 
-int V8FunctionContext::ArgsCount() {
-  return infos_->Length();
+// Wrapped arguments kept by the native function are copied before the call
+// returns.
+void V8FunctionContext::UnwrapArguments() {
+  for (int index = 0; index < infos_.Length(); ++index) {
+    if (!Handle<Value>::Is(NULL, arguments_[index].value)) {
+      String::Unwrap(arguments_[index].value);
+    }
+  }
 }
 
+// String arguments are wrapped rather than copied, most native functions
+// only read them once.
 Handle<Value> V8FunctionContext::GetArgument(int index) {
-  Handle<Value> argument = Value::New((*infos_)[index]);
+  ArgumentMemo* memo = Memo(index);
+
+  if (memo == NULL) {
+    return UndefinedValue::New();
+  }
+
+  if (Handle<Value>::Is(NULL, memo->value)) {
+    v8::Local<v8::Value> argument = infos_[index];
 
-  if (infos_->Length() > index) {
-    argument = Value::New((*infos_)[index]);
+    if (argument->IsString()) {
+      memo->value = String::Wrap(v8::Local<v8::String>::Cast(argument));
+    } else {
+      memo->value = Value::New(argument);
+    }
   }
 
-  return argument;
+  return memo->value;
 }
 
-void V8FunctionContext::SetResult(Handle<Value> result) {
-  infos_->GetReturnValue().Set(result->Extract());
+double V8FunctionContext::GetNumber(int index) const {
+  if (index < 0 || index >= infos_.Length()) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+
+  return infos_[index]->NumberValue();
 }
 
-Handle<V8FunctionContext> V8FunctionContext::New(
-    const v8::FunctionCallbackInfo<v8::Value>& infos) {
-  Handle<V8FunctionContext> handle(new V8FunctionContext(infos));
-  return handle;
+int32_t V8FunctionContext::GetInt32(int index) const {
+  if (index < 0 || index >= infos_.Length()) {
+    return 0;
+  }
+
+  return infos_[index]->Int32Value();
+}
+
+// External ASCII strings are read in place, others are written once to
+// the call arena.
+string_view V8FunctionContext::GetStringView(int index) {
+  ArgumentMemo* memo = Memo(index);
+
+  if (memo == NULL) {
+    return UndefinedView();
+  }
+
+  if (memo->view.data != NULL) {
+    return memo->view;
+  }
+
+  v8::Local<v8::Value> argument = infos_[index];
+  v8::Local<v8::String> string = argument->IsString() ?
+    argument.As<v8::String>() :
+    argument->ToString();
+
+  // ToString threw, the exception is left pending.
+  if (string.IsEmpty()) {
+    memo->view.data = "";
+    return memo->view;
+  }
+
+  if (string->IsExternalAscii()) {
+    const v8::String::ExternalAsciiStringResource* resource =
+      string->GetExternalAsciiStringResource();
+
+    memo->view.data = resource->data();
+    memo->view.length = resource->length();
+    return memo->view;
+  }
+
+  int length = string->Utf8Length();
+
+  memo->buffer = static_cast<char*>(CallArena::Allocate(length + 1));
+  string->WriteUtf8(
+    memo->buffer,
+    length,
+    NULL,
+    v8::String::NO_NULL_TERMINATION);
+  memo->view.data = memo->buffer;
+  memo->view.length = length;
+  return memo->view;
 }
 
 #endif
@@ -84,45 +194,79 @@ JSCFunctionContext::JSCFunctionContext(
   arguments_ref_ = arguments_ref;
   exception_ref_ = exception;
   result_ref_ = JSValueMakeNull(context_ref);
+  arguments_ = NULL;
 }
 
-int JSCFunctionContext::ArgsCount() {
-  return static_cast<int>(argument_count_);
+ArgumentMemo* JSCFunctionContext::Memo(int index) {
+  if (index < 0 || index >= ArgsCount()) {
+    return NULL;
+  }
+
+  if (arguments_ == NULL) {
+    arguments_ = NewArgumentMemos(ArgsCount());
+  }
+
+  return &arguments_[index];
 }
 
 Handle<Value> JSCFunctionContext::GetArgument(int index) {
-  Handle<Value> argument = NullValue::New();
+  ArgumentMemo* memo = Memo(index);
+
+  if (memo == NULL) {
+    return NullValue::New();
+  }
 
-  if (argument_count_ > index) {
-    argument = Value::New(arguments_ref_[index]);
+  if (Handle<Value>::Is(NULL, memo->value)) {
+    memo->value = Value::New(arguments_ref_[index]);
   }
 
-  return argument;
+  return memo->value;
 }
 
-void JSCFunctionContext::SetResult(Handle<Value> val) {
-  result_ref_ = val->Extract();
+double JSCFunctionContext::GetNumber(int index) const {
+  if (index < 0 || index >= ArgsCount()) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+
+  return JSValueToNumber(context_ref_, arguments_ref_[index], NULL);
 }
 
-JSValueRef JSCFunctionContext::ResultRef() {
-  return result_ref_;
+int32_t JSCFunctionContext::GetInt32(int index) const {
+  if (index < 0 || index >= ArgsCount()) {
+    return 0;
+  }
+
+  return NativeToInt32(
+    JSValueToNumber(context_ref_, arguments_ref_[index], NULL));
 }
 
-Handle<JSCFunctionContext> JSCFunctionContext::New(
-    JSContextRef context_ref,
-    JSObjectRef function_ref,
-    JSObjectRef this_ref,
-    size_t argument_count,
-    const JSValueRef* arguments_ref,
-    JSValueRef* exception) {
-  Handle<JSCFunctionContext> handle(new JSCFunctionContext(
-    context_ref,
-    function_ref,
-    this_ref,
-    argument_count,
-    arguments_ref,
-    exception));
-  return handle;
+string_view JSCFunctionContext::GetStringView(int index) {
+  ArgumentMemo* memo = Memo(index);
+
+  if (memo == NULL) {
+    return UndefinedView();
+  }
+
+  if (memo->view.data != NULL) {
+    return memo->view;
+  }
+
+  JSStringRef string =
+    JSValueToStringCopy(context_ref_, arguments_ref_[index], exception_ref_);
+
+  // toString threw, the exception is thrown once the call returns.
+  if (string == NULL) {
+    memo->view.data = "";
+    return memo->view;
+  }
+
+  size_t size = JSStringGetMaximumUTF8CStringSize(string);
+
+  memo->buffer = static_cast<char*>(CallArena::Allocate(size));
+  memo->view.data = memo->buffer;
+  memo->view.length = JSStringGetUTF8CString(string, memo->buffer, size) - 1;
+  JSStringRelease(string);
+  return memo->view;
 }
 
 #endif
@@ -21,20 +21,30 @@
 #ifndef BASTIAN_FCONTEXT_H_
 #define BASTIAN_FCONTEXT_H_
 
+#include <cstdint>
 #include <vector>
+#include "./arena.h"
 #include "./handle.h"
 #include "./value.h"
 
 
 namespace bastian {
 
-class FunctionContext {
- public:
-    virtual int ArgsCount() = 0;
-    virtual Handle<Value> GetArgument(int index) = 0;
-    virtual void SetResult(Handle<Value> result) = 0;
+// Conversions of one argument, made on first use and kept until the call
+// returns.
+struct ArgumentMemo {
+  Handle<Value> value;
+  string_view view;
+
+  // Arena copy of the characters behind view, NULL when they are borrowed
+  // from the engine.
+  char* buffer;
 };
 
+// The memos of a call live in the call arena.
+ArgumentMemo* NewArgumentMemos(int count);
+void DeleteArgumentMemos(ArgumentMemo* arguments, int count);
+
 #define WRAPPED_FUNCTION_NAME(FuncName) Wrapped ## FuncName
 
 
@@ -46,29 +56,62 @@ class FunctionContext {
 
 #include <v8.h>
 
-class V8FunctionContext : FunctionContext {
+// Arguments and result of a native function call. The BASTIAN_FUNCTION
+// wrapper builds it on the stack for the duration of the call, it is
+// neither copied nor kept.
+//
+// GetArgument and GetStringView convert an argument once per call, the
+// numeric accessors read it straight from the engine without creating a
+// Value. A missing argument reads as undefined.
+class V8FunctionContext final {
  public:
-    explicit V8FunctionContext(const v8::FunctionCallbackInfo<v8::Value>&);
-    int ArgsCount();
+    explicit V8FunctionContext(const v8::FunctionCallbackInfo<v8::Value>& infos)
+      : infos_(infos), arguments_(NULL) {}
+
+    inline ~V8FunctionContext() {
+      if (arguments_ != NULL) {
+        UnwrapArguments();
+        DeleteArgumentMemos(arguments_, infos_.Length());
+      }
+    }
+
+    inline int ArgsCount() const {
+      return infos_.Length();
+    }
+
     Handle<Value> GetArgument(int index);
-    void SetResult(Handle<Value> result);
+    double GetNumber(int index) const;
+    int32_t GetInt32(int index) const;
+
+    // Characters of the argument converted to a string, valid until the
+    // call returns.
+    string_view GetStringView(int index);
 
-    static Handle<V8FunctionContext> New(
-      const v8::FunctionCallbackInfo<v8::Value>&);
+    inline void SetResult(Handle<Value> result) {
+      infos_.GetReturnValue().Set(result->Extract());
+    }
 
  private:
-    const v8::FunctionCallbackInfo<v8::Value>* infos_;
+    V8FunctionContext(const V8FunctionContext&);
+    V8FunctionContext& operator= (const V8FunctionContext&);
+
+    ArgumentMemo* Memo(int index);
+    void UnwrapArguments();
+
+    const v8::FunctionCallbackInfo<v8::Value>& infos_;
+    ArgumentMemo* arguments_;
 };
 
-typedef Handle<bastian::V8FunctionContext> FunctionRef;
+typedef bastian::V8FunctionContext FunctionContext;
+typedef bastian::V8FunctionContext* FunctionRef;
 
+// V8 already opens a handle scope around every callback.
 #define BASTIAN_FUNCTION(FuncName) \
 void WRAPPED_FUNCTION_NAME(FuncName) (bastian::FunctionRef); \
 void FuncName(const v8::FunctionCallbackInfo<v8::Value>& infos) { \
-  v8::HandleScope handle_scope(v8::Isolate::GetCurrent()); \
-  bastian::Handle<bastian::V8FunctionContext> ctx \
-    = bastian::V8FunctionContext::New(infos); \
-  WRAPPED_FUNCTION_NAME(FuncName)(ctx); \
+  bastian::CallArena::Scope arena_scope; \
+  bastian::V8FunctionContext ctx(infos); \
+  WRAPPED_FUNCTION_NAME(FuncName)(&ctx); \
 } \
 void WRAPPED_FUNCTION_NAME(FuncName)
 
@@ -84,7 +127,7 @@ void WRAPPED_FUNCTION_NAME(FuncName)
 
 #include <JavascriptCore/JavascriptCore.h>
 
-class JSCFunctionContext : FunctionContext {
+class JSCFunctionContext final {
  public:
     JSCFunctionContext(
       JSContextRef,
@@ -93,20 +136,36 @@ class JSCFunctionContext : FunctionContext {
       size_t,
       const JSValueRef*,
       JSValueRef*);
-    int ArgsCount();
+
+    inline ~JSCFunctionContext() {
+      if (arguments_ != NULL) {
+        DeleteArgumentMemos(arguments_, ArgsCount());
+      }
+    }
+
+    inline int ArgsCount() const {
+      return static_cast<int>(argument_count_);
+    }
+
     Handle<Value> GetArgument(int index);
-    void SetResult(Handle<Value> result);
-    JSValueRef ResultRef();
+    double GetNumber(int index) const;
+    int32_t GetInt32(int index) const;
+    string_view GetStringView(int index);
 
-    static Handle<JSCFunctionContext> New(
-      JSContextRef,
-      JSObjectRef,
-      JSObjectRef,
-      size_t,
-      const JSValueRef*,
-      JSValueRef*);
+    inline void SetResult(Handle<Value> result) {
+      result_ref_ = result->Extract();
+    }
+
+    inline JSValueRef ResultRef() const {
+      return result_ref_;
+    }
 
  private:
+    JSCFunctionContext(const JSCFunctionContext&);
+    JSCFunctionContext& operator= (const JSCFunctionContext&);
+
+    ArgumentMemo* Memo(int index);
+
     JSContextRef context_ref_;
     JSObjectRef function_ref_;
     JSObjectRef this_ref_;
@@ -114,9 +173,11 @@ class JSCFunctionContext : FunctionContext {
     const JSValueRef* arguments_ref_;
     JSValueRef* exception_ref_;
     JSValueRef result_ref_;
+    ArgumentMemo* arguments_;
 };
 
-typedef Handle<bastian::JSCFunctionContext> FunctionRef;
+typedef bastian::JSCFunctionContext FunctionContext;
+typedef bastian::JSCFunctionContext* FunctionRef;
 
 #define BASTIAN_FUNCTION(FuncName) \
 void WRAPPED_FUNCTION_NAME(FuncName) (bastian::FunctionRef); \
@@ -127,16 +188,16 @@ JSValueRef FuncName( \
     size_t argument_count, \
     const JSValueRef* arguments_ref, \
     JSValueRef* exception_ref) { \
-  bastian::Handle<bastian::JSCFunctionContext> ctx \
-    = bastian::JSCFunctionContext::New( \
+  bastian::CallArena::Scope arena_scope; \
+  bastian::JSCFunctionContext ctx( \
     context_ref, \
     function_ref, \
     this_ref, \
     argument_count, \
     arguments_ref, \
     exception_ref); \
-  WRAPPED_FUNCTION_NAME(FuncName)(ctx); \
-  return ctx->ResultRef(); \
+  WRAPPED_FUNCTION_NAME(FuncName)(&ctx); \
+  return ctx.ResultRef(); \
 } \
 void WRAPPED_FUNCTION_NAME(FuncName)
 
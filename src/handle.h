@@ -21,10 +21,61 @@
 #ifndef BASTIAN_HANDLE_H_
 #define BASTIAN_HANDLE_H_
 
+#include <atomic>
 #include <cstdlib>
 
 namespace bastian {
 
+// Reference count of the resources held by a Handle, not thread safe.
+class RefCounted {
+ public:
+  inline void Retain() {
+    ++ref_count_;
+  }
+
+  // Returns true when the last reference is gone.
+  inline bool Release() {
+    return --ref_count_ == 0;
+  }
+
+  inline bool HasOneRef() const {
+    return ref_count_ == 1;
+  }
+
+ protected:
+  inline RefCounted() : ref_count_(0) {}
+
+ private:
+  RefCounted(const RefCounted&);
+  RefCounted& operator= (const RefCounted&);
+
+  int ref_count_;
+};
+
+// Same as RefCounted for resources whose handles are copied and dropped
+// from several threads.
+class ThreadSafeRefCounted {
+ public:
+  inline void Retain() {
+    ref_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  inline bool Release() {
+    return ref_count_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+  }
+
+ protected:
+  inline ThreadSafeRefCounted() : ref_count_(0) {}
+
+ private:
+  ThreadSafeRefCounted(const ThreadSafeRefCounted&);
+  ThreadSafeRefCounted& operator= (const ThreadSafeRefCounted&);
+
+  std::atomic<int> ref_count_;
+};
+
+// Shares ownership of a resource deriving from RefCounted or
+// ThreadSafeRefCounted, the resource is deleted with its last handle.
 template<class ResourceType>
 class Handle {
  public:
@@ -35,7 +86,20 @@ class Handle {
   }
 
   inline Handle<ResourceType> & operator= (const Handle<ResourceType> & other) {
-    resource_ = other.resource_;
+    if (other.resource_ != NULL) {
+      other.resource_->Retain();
+    }
+
+    Reset(other.resource_);
+    return *this;
+  }
+
+  inline Handle<ResourceType> & operator= (Handle<ResourceType> && other) {
+    if (this != &other) {
+      Reset(other.resource_);
+      other.resource_ = NULL;
+    }
+
     return *this;
   }
 
@@ -45,17 +109,50 @@ class Handle {
 
   inline explicit Handle(ResourceType* resource) {
     resource_ = resource;
+
+    if (resource_ != NULL) {
+      resource_->Retain();
+    }
+  }
+
+  inline Handle(const Handle<ResourceType>& other) {
+    resource_ = other.resource_;
+
+    if (resource_ != NULL) {
+      resource_->Retain();
+    }
+  }
+
+  inline Handle(Handle<ResourceType>&& other) {
+    resource_ = other.resource_;
+    other.resource_ = NULL;
+  }
+
+  inline ~Handle() {
+    Reset(NULL);
   }
 
   inline ResourceType* operator->() const {
     return resource_;
   }
 
+  // Drops this reference, the resource is deleted if it was the last one.
   inline void Clear() {
-    delete resource_;
+    Reset(NULL);
   }
 
  private:
+  // Takes over a reference already counted for resource.
+  inline void Reset(ResourceType* resource) {
+    ResourceType* previous = resource_;
+
+    resource_ = resource;
+
+    if (previous != NULL && previous->Release()) {
+      delete previous;
+    }
+  }
+
   ResourceType * resource_;
 };
 
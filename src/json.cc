@@ -0,0 +1,728 @@
+// Copyright David Corticchiato
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "./json.h"
+
+#include <cmath>
+#include <cstdio>
+#include <clocale>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "./value.h"
+
+
+namespace bastian {
+
+// Documents nested deeper are rejected rather than risking the stack,
+// which also stops the writer on cyclic script objects.
+static const int kMaxDepth = 512;
+
+// strtod and snprintf write and read numbers with the decimal point of
+// the current locale, JSON always uses a dot.
+static inline const char * DecimalPoint() {
+  return std::localeconv()->decimal_point;
+}
+
+static inline bool IsStringEnd(unsigned char c) {
+  return c == '"' || c == '\\' || c < 0x20;
+}
+
+const char * ScanJSONString(const char * data, const char * end) {
+#ifdef __SSE2__
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i control = _mm_set1_epi8(0x1f);
+
+  while (end - data >= 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    __m128i matches = _mm_or_si128(
+      _mm_or_si128(
+        _mm_cmpeq_epi8(chunk, quote),
+        _mm_cmpeq_epi8(chunk, backslash)),
+      _mm_cmpeq_epi8(_mm_min_epu8(chunk, control), chunk));
+    int mask = _mm_movemask_epi8(matches);
+
+    if (mask != 0) {
+      return data + __builtin_ctz(mask);
+    }
+
+    data += 16;
+  }
+#endif
+
+  while (data < end && !IsStringEnd(static_cast<unsigned char>(*data))) {
+    ++data;
+  }
+
+  return data;
+}
+
+
+//
+// JSON Parser
+//
+
+
+class JSONParser {
+ public:
+  JSONParser(const char * data, size_t length)
+    : current_(data),
+      end_(data + length) {}
+
+  bool Parse(Handle<Value>* value) {
+    if (!ParseValue(value, 0)) {
+      return false;
+    }
+
+    SkipWhitespace();
+
+    return current_ == end_;
+  }
+
+ private:
+  void SkipWhitespace() {
+    while (current_ < end_ && (*current_ == ' ' || *current_ == '\n' ||
+        *current_ == '\r' || *current_ == '\t')) {
+      ++current_;
+    }
+  }
+
+  bool Consume(char c) {
+    SkipWhitespace();
+
+    if (current_ == end_ || *current_ != c) {
+      return false;
+    }
+
+    ++current_;
+    return true;
+  }
+
+  bool ConsumeLiteral(const char * literal, size_t length) {
+    if (static_cast<size_t>(end_ - current_) < length ||
+        std::memcmp(current_, literal, length) != 0) {
+      return false;
+    }
+
+    current_ += length;
+    return true;
+  }
+
+  bool SkipDigits() {
+    const char * start = current_;
+
+    while (current_ < end_ && *current_ >= '0' && *current_ <= '9') {
+      ++current_;
+    }
+
+    return current_ > start;
+  }
+
+  bool ParseValue(Handle<Value>* value, int depth) {
+    SkipWhitespace();
+
+    if (current_ == end_ || depth > kMaxDepth) {
+      return false;
+    }
+
+    switch (*current_) {
+      case '{':
+        return ParseObject(value, depth);
+      case '[':
+        return ParseArray(value, depth);
+      case '"': {
+        std::string string;
+
+        if (!ParseString(&string)) {
+          return false;
+        }
+
+        *value = String::New(string);
+        return true;
+      }
+      case 't':
+        *value = Boolean::New(true);
+        return ConsumeLiteral("true", 4);
+      case 'f':
+        *value = Boolean::New(false);
+        return ConsumeLiteral("false", 5);
+      case 'n':
+        *value = NullValue::New();
+        return ConsumeLiteral("null", 4);
+      default:
+        return ParseNumber(value);
+    }
+  }
+
+  bool ParseObject(Handle<Value>* value, int depth) {
+    std::vector<std::pair<std::string, Handle<Value>>> properties;
+
+    ++current_;
+
+    if (Consume('}')) {
+      *value = Object::New(properties);
+      return true;
+    }
+
+    do {
+      std::pair<std::string, Handle<Value>> property;
+
+      SkipWhitespace();
+
+      if (current_ == end_ || *current_ != '"' ||
+          !ParseString(&property.first) ||
+          !Consume(':') ||
+          !ParseValue(&property.second, depth + 1)) {
+        return false;
+      }
+
+      properties.push_back(std::move(property));
+    } while (Consume(','));
+
+    if (!Consume('}')) {
+      return false;
+    }
+
+    *value = Object::New(properties);
+    return true;
+  }
+
+  bool ParseArray(Handle<Value>* value, int depth) {
+    std::vector<Handle<Value>> elements;
+
+    ++current_;
+
+    if (Consume(']')) {
+      *value = Array::New(elements);
+      return true;
+    }
+
+    do {
+      Handle<Value> element;
+
+      if (!ParseValue(&element, depth + 1)) {
+        return false;
+      }
+
+      elements.push_back(std::move(element));
+    } while (Consume(','));
+
+    if (!Consume(']')) {
+      return false;
+    }
+
+    *value = Array::New(elements);
+    return true;
+  }
+
+  bool ParseHex(unsigned* code) {
+    if (end_ - current_ < 4) {
+      return false;
+    }
+
+    *code = 0;
+
+    for (int index = 0; index < 4; ++index) {
+      char c = *current_++;
+
+      *code <<= 4;
+
+      if (c >= '0' && c <= '9') {
+        *code |= c - '0';
+      } else if (c >= 'a' && c <= 'f') {
+        *code |= c - 'a' + 10;
+      } else if (c >= 'A' && c <= 'F') {
+        *code |= c - 'A' + 10;
+      } else {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  // Lone surrogates are encoded as they are, as V8 does.
+  static void AppendUTF8(unsigned code, std::string* string) {
+    if (code < 0x80) {
+      string->push_back(static_cast<char>(code));
+    } else if (code < 0x800) {
+      string->push_back(static_cast<char>(0xc0 | (code >> 6)));
+      string->push_back(static_cast<char>(0x80 | (code & 0x3f)));
+    } else if (code < 0x10000) {
+      string->push_back(static_cast<char>(0xe0 | (code >> 12)));
+      string->push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+      string->push_back(static_cast<char>(0x80 | (code & 0x3f)));
+    } else {
+      string->push_back(static_cast<char>(0xf0 | (code >> 18)));
+      string->push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3f)));
+      string->push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+      string->push_back(static_cast<char>(0x80 | (code & 0x3f)));
+    }
+  }
+
+  bool ParseEscape(std::string* string) {
+    unsigned code;
+
+    if (current_ == end_) {
+      return false;
+    }
+
+    switch (*current_++) {
+      case '"':
+        string->push_back('"');
+        return true;
+      case '\\':
+        string->push_back('\\');
+        return true;
+      case '/':
+        string->push_back('/');
+        return true;
+      case 'b':
+        string->push_back('\b');
+        return true;
+      case 'f':
+        string->push_back('\f');
+        return true;
+      case 'n':
+        string->push_back('\n');
+        return true;
+      case 'r':
+        string->push_back('\r');
+        return true;
+      case 't':
+        string->push_back('\t');
+        return true;
+      case 'u':
+        if (!ParseHex(&code)) {
+          return false;
+        }
+
+        if (code >= 0xd800 && code < 0xdc00 && end_ - current_ >= 6 &&
+            current_[0] == '\\' && current_[1] == 'u') {
+          const char * low_start = current_;
+          unsigned low;
+
+          current_ += 2;
+
+          if (ParseHex(&low) && low >= 0xdc00 && low < 0xe000) {
+            code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+          } else {
+            current_ = low_start;
+          }
+        }
+
+        AppendUTF8(code, string);
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  bool ParseString(std::string* string) {
+    ++current_;
+
+    while (true) {
+      const char * run_end = ScanJSONString(current_, end_);
+
+      string->append(current_, run_end - current_);
+      current_ = run_end;
+
+      if (current_ == end_) {
+        return false;
+      }
+
+      char c = *current_++;
+
+      if (c == '"') {
+        return true;
+      }
+
+      if (c != '\\' || !ParseEscape(string)) {
+        return false;
+      }
+    }
+  }
+
+  bool ParseNumber(Handle<Value>* value) {
+    const char * start = current_;
+
+    if (*current_ == '-') {
+      ++current_;
+    }
+
+    if (current_ < end_ && *current_ == '0') {
+      ++current_;
+    } else if (!SkipDigits()) {
+      return false;
+    }
+
+    if (current_ < end_ && *current_ == '.') {
+      ++current_;
+
+      if (!SkipDigits()) {
+        return false;
+      }
+    }
+
+    if (current_ < end_ && (*current_ == 'e' || *current_ == 'E')) {
+      ++current_;
+
+      if (current_ < end_ && (*current_ == '+' || *current_ == '-')) {
+        ++current_;
+      }
+
+      if (!SkipDigits()) {
+        return false;
+      }
+    }
+
+    // strtod needs a terminated string, the text is not.
+    char buffer[64];
+    std::string long_number;
+    size_t length = current_ - start;
+    const char * number = buffer;
+    const char * point = DecimalPoint();
+
+    if (length < sizeof(buffer) && std::strcmp(point, ".") == 0) {
+      std::memcpy(buffer, start, length);
+      buffer[length] = '\0';
+    } else {
+      long_number.assign(start, length);
+
+      size_t dot = long_number.find('.');
+
+      if (dot != std::string::npos) {
+        long_number.replace(dot, 1, point);
+      }
+
+      number = long_number.c_str();
+    }
+
+    *value = Number::New(std::strtod(number, NULL));
+    return true;
+  }
+
+  const char * current_;
+  const char * end_;
+};
+
+
+//
+// JSON Writer
+//
+
+
+class JSONWriter {
+ public:
+  explicit JSONWriter(std::string* json) : json_(json), failed_(false) {}
+
+  bool Failed() {
+    return failed_;
+  }
+
+  // Returns false when the value has no JSON text, as with undefined. The
+  // key is the one toJSON is called with.
+  bool Write(Value* value, int depth, const std::string& key) {
+    if (depth > kMaxDepth) {
+      failed_ = true;
+      return false;
+    }
+
+    if (value->IsNull()) {
+      json_->append("null");
+    } else if (value->IsBoolean()) {
+      json_->append(value->BooleanValue() ? "true" : "false");
+    } else if (value->IsNumber()) {
+      WriteNumber(value->NumberValue());
+    } else if (value->IsString()) {
+      WriteString(value->StringView());
+    } else if (value->IsArray()) {
+      WriteArray(static_cast<Array*>(value), depth);
+    } else if (value->IsTypedArray()) {
+      WriteTypedArray(value);
+    } else if (value->IsArrayBuffer()) {
+      json_->append("{}");
+    } else if (value->IsObject()) {
+      bool threw;
+      Handle<Value> replacement =
+        static_cast<Object*>(value)->JSONValue(key, &threw);
+
+      if (threw) {
+        failed_ = true;
+        return false;
+      } else if (Handle<Value>::Is(NULL, replacement)) {
+        WriteObject(static_cast<Object*>(value), depth);
+      } else if (replacement->IsObject()) {
+        // toJSON is not called again on what it returned.
+        WriteObject(static_cast<Object*>(replacement.operator->()), depth);
+      } else {
+        return Write(replacement.operator->(), depth, key);
+      }
+    } else {
+      return false;
+    }
+
+    return true;
+  }
+
+ private:
+  // Laid out as Number.prototype.toString does, with the fewest digits
+  // from 15 to 17 which read back as the same number.
+  void WriteNumber(double number) {
+    char buffer[32];
+    char digits[20];
+    int digit_count = 0;
+    int exponent;
+
+    if (!std::isfinite(number)) {
+      json_->append("null");
+      return;
+    }
+
+    if (number == 0) {
+      json_->push_back('0');
+      return;
+    }
+
+    if (number < 0) {
+      json_->push_back('-');
+      number = -number;
+    }
+
+    for (int precision = 15; precision <= 17; ++precision) {
+      std::snprintf(buffer, sizeof(buffer), "%.*e", precision - 1, number);
+
+      if (std::strtod(buffer, NULL) == number) {
+        break;
+      }
+    }
+
+    // buffer holds d.ddde[+-]xx, whatever the decimal point.
+    const char * current = buffer;
+
+    for (; *current != 'e'; ++current) {
+      if (*current >= '0' && *current <= '9') {
+        digits[digit_count++] = *current;
+      }
+    }
+
+    exponent = std::atoi(current + 1) + 1;
+
+    while (digit_count > 1 && digits[digit_count - 1] == '0') {
+      --digit_count;
+    }
+
+    if (digit_count <= exponent && exponent <= 21) {
+      json_->append(digits, digit_count);
+      json_->append(exponent - digit_count, '0');
+    } else if (0 < exponent && exponent <= 21) {
+      json_->append(digits, exponent);
+      json_->push_back('.');
+      json_->append(digits + exponent, digit_count - exponent);
+    } else if (-6 < exponent && exponent <= 0) {
+      json_->append("0.");
+      json_->append(-exponent, '0');
+      json_->append(digits, digit_count);
+    } else {
+      json_->push_back(digits[0]);
+
+      if (digit_count > 1) {
+        json_->push_back('.');
+        json_->append(digits + 1, digit_count - 1);
+      }
+
+      int length = std::snprintf(
+        buffer, sizeof(buffer), "e%c%d",
+        exponent > 0 ? '+' : '-',
+        exponent > 0 ? exponent - 1 : 1 - exponent);
+
+      json_->append(buffer, length);
+    }
+  }
+
+  void WriteString(string_view view) {
+    const char * current = view.data;
+    const char * end = view.data + view.length;
+
+    json_->push_back('"');
+
+    while (current < end) {
+      const char * run_end = ScanJSONString(current, end);
+
+      json_->append(current, run_end - current);
+
+      if (run_end == end) {
+        break;
+      }
+
+      switch (*run_end) {
+        case '"':
+          json_->append("\\\"");
+          break;
+        case '\\':
+          json_->append("\\\\");
+          break;
+        case '\b':
+          json_->append("\\b");
+          break;
+        case '\f':
+          json_->append("\\f");
+          break;
+        case '\n':
+          json_->append("\\n");
+          break;
+        case '\r':
+          json_->append("\\r");
+          break;
+        case '\t':
+          json_->append("\\t");
+          break;
+        default: {
+          char escape[8];
+          int length = std::snprintf(
+            escape, sizeof(escape), "\\u%04x",
+            static_cast<unsigned char>(*run_end));
+
+          json_->append(escape, length);
+          break;
+        }
+      }
+
+      current = run_end + 1;
+    }
+
+    json_->push_back('"');
+  }
+
+  void WriteArray(Array* array, int depth) {
+    size_t length = array->Length();
+
+    json_->push_back('[');
+
+    for (size_t index = 0; index < length; ++index) {
+      Handle<Value> element = array->Get(index);
+
+      if (index > 0) {
+        json_->push_back(',');
+      }
+
+      if (!Write(element.operator->(), depth + 1,
+          element->IsObject() ? std::to_string(index) : std::string())) {
+        json_->append("null");
+      }
+    }
+
+    json_->push_back(']');
+  }
+
+  void WriteTypedArray(Value* value) {
+    std::vector<double> elements;
+
+    value->ToVector(&elements);
+    json_->push_back('[');
+
+    for (size_t index = 0; index < elements.size(); ++index) {
+      if (index > 0) {
+        json_->push_back(',');
+      }
+
+      WriteNumber(elements[index]);
+    }
+
+    json_->push_back(']');
+  }
+
+  // Properties without JSON text are left out, a property read which
+  // throws fails the whole text.
+  void WriteObject(Object* object, int depth) {
+    const std::vector<std::string>& keys = object->Keys();
+    bool empty = true;
+
+    json_->push_back('{');
+
+    for (size_t index = 0; index < keys.size() && !failed_; ++index) {
+      bool threw;
+      Handle<Value> property = object->Get(keys[index], &threw);
+      size_t mark = json_->size();
+
+      if (threw) {
+        failed_ = true;
+        break;
+      }
+
+      string_view key = { keys[index].data(), keys[index].size() };
+
+      if (!empty) {
+        json_->push_back(',');
+      }
+
+      WriteString(key);
+      json_->push_back(':');
+
+      if (Write(property.operator->(), depth + 1, keys[index])) {
+        empty = false;
+      } else {
+        json_->resize(mark);
+      }
+    }
+
+    json_->push_back('}');
+  }
+
+  std::string* json_;
+  bool failed_;
+};
+
+
+//
+// Common Value
+//
+
+
+Handle<Value> Value::FromJSON(const char * data, size_t length) {
+  Handle<Value> value;
+  JSONParser parser(data, length);
+
+  if (!parser.Parse(&value)) {
+    return UndefinedValue::New();
+  }
+
+  return value;
+}
+
+std::string Value::ToJSON() {
+  std::string json;
+  JSONWriter writer(&json);
+
+  if (!writer.Write(this, 0, std::string()) || writer.Failed()) {
+    json.clear();
+  }
+
+  return json;
+}
+
+}  // namespace bastian
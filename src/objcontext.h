@@ -40,7 +40,7 @@ class V8ObjectContext;
 
 typedef void (*v8_obj_generator)(Handle<V8ObjectContext>);
 
-class V8ObjectContext {
+class V8ObjectContext : public RefCounted {
  public:
     V8ObjectContext();
     void Export(
@@ -100,7 +100,7 @@ class JSCEngine;
 typedef void (*jsc_obj_generator)(Handle<JSCObjectContext>);
 
 
-class JSCObjectContext {
+class JSCObjectContext : public RefCounted {
   friend class JSCEngine;
   friend class Object;
 
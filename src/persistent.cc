@@ -0,0 +1,117 @@
+// Copyright David Corticchiato
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "./persistent.h"
+
+
+namespace bastian {
+
+#ifdef BASTIAN_V8
+
+static uint32_t DataSlot() {
+  return v8::Isolate::GetNumberOfDataSlots() - 1;
+}
+
+Handle<IsolateHandles> IsolateHandles::Get(v8::Isolate* isolate) {
+  IsolateHandles* handles =
+    static_cast<IsolateHandles*>(isolate->GetData(DataSlot()));
+
+  // The slot holds a reference until the isolate is disposed.
+  if (handles == NULL) {
+    handles = new IsolateHandles(isolate);
+    handles->Retain();
+    isolate->SetData(DataSlot(), handles);
+  }
+
+  return Handle<IsolateHandles>(handles);
+}
+
+void IsolateHandles::ReleaseDropped(v8::Isolate* isolate) {
+  IsolateHandles* handles =
+    static_cast<IsolateHandles*>(isolate->GetData(DataSlot()));
+  std::vector<v8::Persistent<v8::Value>*> dropped;
+
+  if (handles == NULL) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(handles->mutex_);
+    dropped.swap(handles->dropped_);
+  }
+
+  for (size_t index = 0; index < dropped.size(); ++index) {
+    dropped[index]->Reset();
+    delete dropped[index];
+  }
+}
+
+void IsolateHandles::Dispose(v8::Isolate* isolate) {
+  IsolateHandles* handles =
+    static_cast<IsolateHandles*>(isolate->GetData(DataSlot()));
+
+  if (handles == NULL) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(handles->mutex_);
+
+    handles->disposed_ = true;
+
+    for (size_t index = 0; index < handles->dropped_.size(); ++index) {
+      delete handles->dropped_[index];
+    }
+
+    handles->dropped_.clear();
+  }
+
+  isolate->SetData(DataSlot(), NULL);
+
+  if (handles->Release()) {
+    delete handles;
+  }
+}
+
+IsolateHandles::IsolateHandles(v8::Isolate* isolate)
+  : isolate_(isolate), disposed_(false) {}
+
+IsolateHandles::~IsolateHandles() {}
+
+// A handle of a disposed isolate is only deleted, persistents do not reset
+// themselves when deleted.
+void IsolateHandles::Drop(v8::Persistent<v8::Value>* handle) {
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  if (disposed_) {
+    lock.unlock();
+    delete handle;
+  } else if (v8::Isolate::GetCurrent() != isolate_) {
+    dropped_.push_back(handle);
+  } else {
+    lock.unlock();
+    handle->Reset();
+    delete handle;
+  }
+}
+
+#endif
+
+}  // namespace bastian
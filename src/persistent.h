@@ -0,0 +1,121 @@
+// Copyright David Corticchiato
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef BASTIAN_PERSISTENT_H_
+#define BASTIAN_PERSISTENT_H_
+
+#ifdef BASTIAN_V8
+
+#include <v8.h>
+
+#include <mutex>
+#include <vector>
+
+#include "./handle.h"
+
+
+namespace bastian {
+
+// The persistent handles which values hold in an isolate, kept in the
+// isolate's last data slot. A value may be dropped on any thread and after
+// its isolate is gone: a handle dropped away from the isolate's thread is
+// released the next time an engine runs on that thread, the handles left
+// when the isolate is disposed go away with it.
+class IsolateHandles : public ThreadSafeRefCounted {
+ public:
+  static Handle<IsolateHandles> Get(v8::Isolate* isolate);
+
+  // Both are called on the isolate's thread, Dispose right before the
+  // isolate is disposed.
+  static void ReleaseDropped(v8::Isolate* isolate);
+  static void Dispose(v8::Isolate* isolate);
+
+  ~IsolateHandles();
+
+  // Takes over a heap allocated persistent of any type, persistents only
+  // differ by the type of their handle.
+  void Drop(v8::Persistent<v8::Value>* handle);
+
+ private:
+  explicit IsolateHandles(v8::Isolate* isolate);
+  IsolateHandles(const IsolateHandles&);
+  IsolateHandles& operator= (const IsolateHandles&);
+
+  v8::Isolate* isolate_;
+  std::mutex mutex_;
+  std::vector<v8::Persistent<v8::Value>*> dropped_;
+  bool disposed_;
+};
+
+// Persistent handle of a value, which can be reset on any thread and after
+// the isolate is disposed.
+template<class T>
+class BoundPersistent {
+ public:
+  inline BoundPersistent() : handle_(NULL) {}
+
+  inline ~BoundPersistent() {
+    Reset();
+  }
+
+  inline bool IsEmpty() const {
+    return handle_ == NULL;
+  }
+
+  inline v8::Local<T> Get(v8::Isolate* isolate) const {
+    if (handle_ == NULL) {
+      return v8::Local<T>();
+    }
+
+    return v8::Local<T>::New(isolate, *handle_);
+  }
+
+  inline void Reset(v8::Isolate* isolate, const v8::Local<T>& value) {
+    Reset();
+
+    if (value.IsEmpty()) {
+      return;
+    }
+
+    handles_ = IsolateHandles::Get(isolate);
+    handle_ = new v8::Persistent<T>(isolate, value);
+  }
+
+  inline void Reset() {
+    if (handle_ != NULL) {
+      handles_->Drop(reinterpret_cast<v8::Persistent<v8::Value>*>(handle_));
+      handles_.Clear();
+      handle_ = NULL;
+    }
+  }
+
+ private:
+  BoundPersistent(const BoundPersistent&);
+  BoundPersistent& operator= (const BoundPersistent&);
+
+  Handle<IsolateHandles> handles_;
+  v8::Persistent<T>* handle_;
+};
+
+}  // namespace bastian
+
+#endif
+
+#endif  // BASTIAN_PERSISTENT_H_
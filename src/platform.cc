@@ -0,0 +1,333 @@
+// Copyright David Corticchiato
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "./platform.h"
+
+#include <cstdlib>
+
+#include "./codecache.h"
+#include "./persistent.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+
+namespace bastian {
+
+//
+// Common Platform
+//
+
+
+static bool initialized = false;
+
+InitOptions::InitOptions() {
+  worker_threads = 0;
+#ifdef BASTIAN_V8
+  platform = NULL;
+  code_cache = false;
+#endif
+}
+
+bool Init() {
+  return Init(InitOptions());
+}
+
+
+//
+// V8 Platform
+//
+
+
+#ifdef BASTIAN_V8
+
+static WorkerPlatform* worker_platform = NULL;
+
+// Array buffers allocated by scripts are freed with free() once handed to
+// the host, see value.cc.
+class MallocArrayBufferAllocator : public v8::ArrayBuffer::Allocator {
+ public:
+  void* Allocate(size_t length) {
+    return std::calloc(length, 1);
+  }
+
+  void* AllocateUninitialized(size_t length) {
+    return std::malloc(length);
+  }
+
+  void Free(void* data, size_t length) {
+    std::free(data);
+  }
+};
+
+static MallocArrayBufferAllocator array_buffer_allocator;
+
+bool Init(const InitOptions& options) {
+  if (initialized) {
+    return false;
+  }
+
+  v8::Platform* platform = options.platform;
+
+  if (platform == NULL) {
+    worker_platform = new WorkerPlatform(
+      options.worker_threads, options.cpu_affinity);
+    platform = worker_platform;
+  }
+
+  if (!options.v8_flags.empty()) {
+    v8::V8::SetFlagsFromString(
+      options.v8_flags.data(), static_cast<int>(options.v8_flags.size()));
+  }
+
+  if (options.code_cache) {
+    CodeCache::Setup(options.v8_flags);
+  }
+
+  v8::V8::InitializePlatform(platform);
+  v8::V8::SetArrayBufferAllocator(&array_buffer_allocator);
+  v8::V8::Initialize();
+  initialized = true;
+
+  return true;
+}
+
+bool OwnsArrayBufferAllocator() {
+  return initialized;
+}
+
+void Shutdown(bool fast_exit) {
+  if (!initialized || fast_exit) {
+    return;
+  }
+
+  v8::V8::Dispose();
+  v8::V8::ShutdownPlatform();
+  delete worker_platform;
+  worker_platform = NULL;
+}
+
+bool PumpMessageLoop() {
+  if (worker_platform == NULL) {
+    return false;
+  }
+
+  return worker_platform->PumpMessageLoop(v8::Isolate::GetCurrent());
+}
+
+void SetTaskWaker(std::function<void()> waker) {
+  if (worker_platform != NULL) {
+    worker_platform->SetTaskWaker(v8::Isolate::GetCurrent(), waker);
+  }
+}
+
+v8::Isolate* NewIsolate() {
+  v8::Isolate* isolate = v8::Isolate::New();
+  v8::Isolate::Scope isolate_scope(isolate);
+  v8::HandleScope handle_scope(isolate);
+
+  v8::ObjectTemplate::New(isolate);
+
+  return isolate;
+}
+
+void DisposeIsolate(v8::Isolate* isolate) {
+  IsolateHandles::Dispose(isolate);
+  isolate->Dispose();
+}
+
+WorkerPlatform::WorkerPlatform(
+    int worker_threads,
+    const std::vector<int>& cpu_affinity) {
+  stopping_ = false;
+
+  if (worker_threads <= 0) {
+    worker_threads = static_cast<int>(std::thread::hardware_concurrency());
+  }
+
+  if (worker_threads <= 0) {
+    worker_threads = 1;
+  }
+
+  for (int index = 0; index < worker_threads; ++index) {
+    int cpu = cpu_affinity.empty() ?
+      -1 :
+      cpu_affinity[index % cpu_affinity.size()];
+
+    workers_.push_back(std::thread(&WorkerPlatform::Work, this, cpu));
+  }
+}
+
+WorkerPlatform::~WorkerPlatform() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+
+  task_ready_.notify_all();
+
+  for (size_t index = 0; index < workers_.size(); ++index) {
+    workers_[index].join();
+  }
+
+  for (auto& queue : foreground_tasks_) {
+    for (size_t index = 0; index < queue.second.size(); ++index) {
+      delete queue.second[index];
+    }
+  }
+}
+
+void WorkerPlatform::CallOnBackgroundThread(
+    v8::Task* task,
+    ExpectedRuntime runtime) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    background_tasks_.push_back(task);
+  }
+
+  task_ready_.notify_one();
+}
+
+void WorkerPlatform::CallOnForegroundThread(
+    v8::Isolate* isolate,
+    v8::Task* task) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  foreground_tasks_[isolate].push_back(task);
+
+  // Called under the lock, a waker is never called once removed.
+  auto found = task_wakers_.find(isolate);
+
+  if (found != task_wakers_.end()) {
+    found->second();
+  }
+}
+
+void WorkerPlatform::SetTaskWaker(
+    v8::Isolate* isolate,
+    std::function<void()> waker) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (waker) {
+    task_wakers_[isolate] = waker;
+  } else {
+    task_wakers_.erase(isolate);
+  }
+}
+
+bool WorkerPlatform::PumpMessageLoop(v8::Isolate* isolate) {
+  v8::Task* task;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto queue = foreground_tasks_.find(isolate);
+
+    if (queue == foreground_tasks_.end() || queue->second.empty()) {
+      return false;
+    }
+
+    task = queue->second.front();
+    queue->second.pop_front();
+
+    if (queue->second.empty()) {
+      foreground_tasks_.erase(queue);
+    }
+  }
+
+  task->Run();
+  delete task;
+
+  return true;
+}
+
+int WorkerPlatform::WorkerThreads() {
+  return static_cast<int>(workers_.size());
+}
+
+// Pending background tasks are still run when stopping, V8 may be waiting
+// on them. The thread is pinned before it runs any task.
+void WorkerPlatform::Work(int cpu) {
+#ifdef __linux__
+  if (cpu >= 0) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+  }
+#endif
+
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  for (;;) {
+    task_ready_.wait(lock, [this] {
+      return stopping_ || !background_tasks_.empty();
+    });
+
+    if (background_tasks_.empty()) {
+      break;
+    }
+
+    v8::Task* task = background_tasks_.front();
+    background_tasks_.pop_front();
+    lock.unlock();
+
+    task->Run();
+    delete task;
+
+    lock.lock();
+  }
+}
+
+#endif
+
+
+//
+// JavascriptCore Platform
+//
+
+
+#ifdef BASTIAN_JSC
+
+// JavaScriptCore schedules its own GC and JIT threads.
+bool Init(const InitOptions& options) {
+  if (initialized) {
+    return false;
+  }
+
+  initialized = true;
+
+  return true;
+}
+
+void Shutdown(bool fast_exit) {
+}
+
+bool PumpMessageLoop() {
+  return false;
+}
+
+void SetTaskWaker(std::function<void()> waker) {
+}
+
+#endif
+
+}  // namespace bastian
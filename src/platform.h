@@ -0,0 +1,138 @@
+// Copyright David Corticchiato
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef BASTIAN_PLATFORM_H_
+#define BASTIAN_PLATFORM_H_
+
+#ifdef BASTIAN_V8
+#include <v8.h>
+#include <v8-platform.h>
+#endif
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace bastian {
+
+struct InitOptions {
+  InitOptions();
+
+  // Number of background threads running GC and compiler tasks, 0 picks
+  // one per core.
+  int worker_threads;
+
+  // CPUs the background threads are pinned to, worker i runs on
+  // cpu_affinity[i % size]. Left unpinned when empty, only honoured on
+  // Linux.
+  std::vector<int> cpu_affinity;
+
+#ifdef BASTIAN_V8
+  // Platform given to V8 instead of the bastian one, worker_threads and
+  // cpu_affinity are then ignored. The caller keeps ownership.
+  v8::Platform* platform;
+
+  // Flags set on V8 before it starts, they are part of the code cache key.
+  // Flags set on V8 directly are not, they must not change between
+  // processes sharing a code cache directory.
+  std::string v8_flags;
+
+  // Lets engines use EngineOptions::code_cache_dir. Turns on the
+  // serialization of top level code for the whole process.
+  bool code_cache;
+#endif
+};
+
+// Sets up the process wide engine state, must be called before any engine
+// is created. Returns false when already initialized. With V8 it also
+// installs the allocator of array buffers, which the host must not set.
+bool Init();
+bool Init(const InitOptions& options);
+
+// Tears down the process wide engine state, engines must be disposed
+// first. A fast exit skips the teardown altogether and leaves isolates,
+// heaps and threads to the process exit, engines need not be disposed.
+// The engines can not be initialized again afterwards.
+void Shutdown(bool fast_exit = false);
+
+// Runs the tasks the engine posted for the current thread's isolate,
+// returns true when a task was run. Does nothing with a custom platform.
+// Engines pump pending tasks when a run starts.
+bool PumpMessageLoop();
+
+// Calls waker, from any thread, whenever the engine posts a task for the
+// current thread's isolate, so that a thread waiting for work can pump
+// it. An empty function removes the waker, which is not called anymore
+// once this returns. The waker must not post tasks itself. Does nothing
+// with a custom platform.
+void SetTaskWaker(std::function<void()> waker);
+
+
+#ifdef BASTIAN_V8
+
+// Creates an isolate which handles can be made in right away, V8 only
+// initializes a new isolate on the first API call that needs it.
+v8::Isolate* NewIsolate();
+
+// Disposes an isolate, values still holding handles in it stop using
+// them. Called on the isolate's thread once it has been exited.
+void DisposeIsolate(v8::Isolate* isolate);
+
+// True once Init installed the allocator of array buffers. The memory of
+// buffers allocated by scripts can only be handed to the host then.
+bool OwnsArrayBufferAllocator();
+
+// Runs background tasks on a fixed set of threads and keeps foreground
+// tasks queued per isolate until the isolate's thread pumps them.
+class WorkerPlatform : public v8::Platform {
+ public:
+  WorkerPlatform(int worker_threads, const std::vector<int>& cpu_affinity);
+  ~WorkerPlatform();
+
+  void CallOnBackgroundThread(v8::Task* task, ExpectedRuntime runtime);
+  void CallOnForegroundThread(v8::Isolate* isolate, v8::Task* task);
+  bool PumpMessageLoop(v8::Isolate* isolate);
+  void SetTaskWaker(v8::Isolate* isolate, std::function<void()> waker);
+  int WorkerThreads();
+
+ private:
+  void Work(int cpu);
+
+  std::vector<std::thread> workers_;
+  std::deque<v8::Task*> background_tasks_;
+  std::map<v8::Isolate*, std::deque<v8::Task*>> foreground_tasks_;
+  std::map<v8::Isolate*, std::function<void()>> task_wakers_;
+  std::mutex mutex_;
+  std::condition_variable task_ready_;
+  bool stopping_;
+};
+
+#endif
+
+}  // namespace bastian
+
+#endif  // BASTIAN_PLATFORM_H_
@@ -0,0 +1,233 @@
+// Copyright David Corticchiato
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "./pool.h"
+
+#include "./platform.h"
+#include "./runcontext.h"
+
+
+namespace bastian {
+
+//
+// Common EnginePool
+//
+
+
+EnginePool::~EnginePool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+
+  job_ready_.notify_all();
+
+  for (unsigned index = 0; index < workers_.size(); ++index) {
+    workers_.at(index).join();
+  }
+}
+
+Handle<Value> EnginePool::Run(const char * raw_source) {
+  Job job;
+  job.source = raw_source;
+  job.done = false;
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  jobs_.push_back(&job);
+  job_ready_.notify_one();
+  job_done_.wait(lock, [&job] { return job.done; });
+
+  return job.result;
+}
+
+int EnginePool::Size() {
+  return static_cast<int>(workers_.size());
+}
+
+void EnginePool::Start(int size) {
+  stopping_ = false;
+
+  if (size <= 0) {
+    size = static_cast<int>(std::thread::hardware_concurrency());
+  }
+
+  if (size <= 0) {
+    size = 1;
+  }
+
+  for (int index = 0; index < size; ++index) {
+    workers_.push_back(std::thread(&EnginePool::Work, this));
+  }
+}
+
+// The worker sleeps until a job comes, or until the engine posts a task
+// for its isolate, which sets tasks_posted.
+void EnginePool::Serve(Handle<Engine> engine, bool* tasks_posted) {
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  for (;;) {
+    // Idle time goes to the tasks the engine posted for this thread and
+    // to warming up contexts for the next jobs.
+    while (!stopping_ && jobs_.empty()) {
+      *tasks_posted = false;
+      lock.unlock();
+
+      bool busy;
+      {
+#ifdef BASTIAN_V8
+        v8::HandleScope handle_scope(v8::Isolate::GetCurrent());
+#endif
+        busy = PumpMessageLoop() || engine->FillContextPool();
+      }
+
+      lock.lock();
+
+      if (!busy) {
+        break;
+      }
+    }
+
+    job_ready_.wait(lock, [this, tasks_posted] {
+      return stopping_ || !jobs_.empty() || *tasks_posted;
+    });
+
+    if (jobs_.empty()) {
+      if (stopping_) {
+        break;
+      }
+
+      continue;
+    }
+
+    Job* job = jobs_.front();
+    jobs_.pop_front();
+    lock.unlock();
+
+    {
+#ifdef BASTIAN_V8
+      v8::HandleScope handle_scope(v8::Isolate::GetCurrent());
+#endif
+      job->result = engine->Run(job->source);
+    }
+
+    lock.lock();
+    job->done = true;
+    job_done_.notify_all();
+  }
+}
+
+
+//
+// V8 EnginePool
+//
+
+
+#ifdef BASTIAN_V8
+
+Handle<EnginePool> EnginePool::New(v8_obj_generator obj_generator, int size) {
+  return New(obj_generator, EngineOptions(), size);
+}
+
+Handle<EnginePool> EnginePool::New(
+    v8_obj_generator obj_generator,
+    const EngineOptions& options,
+    int size) {
+  Handle<EnginePool> pool(new EnginePool(obj_generator, options, size));
+  return pool;
+}
+
+EnginePool::EnginePool(
+    v8_obj_generator obj_generator,
+    const EngineOptions& options,
+    int size) : options_(options) {
+  obj_generator_ = obj_generator;
+  Start(size);
+}
+
+void EnginePool::Work() {
+  v8::Isolate* isolate = NewIsolate();
+
+  {
+    v8::Isolate::Scope isolate_scope(isolate);
+    v8::HandleScope handle_scope(isolate);
+    EngineOptions options = options_;
+    options.isolate = isolate;
+    Handle<Engine> engine = Engine::New(obj_generator_, options);
+    bool tasks_posted = false;
+
+    SetTaskWaker([this, &tasks_posted] {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_posted = true;
+      job_ready_.notify_all();
+    });
+
+    Serve(engine, &tasks_posted);
+    SetTaskWaker(std::function<void()>());
+    engine.Clear();
+    RunContext::SetCurrent(Handle<RunContext>());
+  }
+
+  DisposeIsolate(isolate);
+}
+
+#endif
+
+
+//
+// JavascriptCore EnginePool
+//
+
+
+#ifdef BASTIAN_JSC
+
+Handle<EnginePool> EnginePool::New(jsc_obj_generator obj_generator, int size) {
+  return New(obj_generator, EngineOptions(), size);
+}
+
+Handle<EnginePool> EnginePool::New(
+    jsc_obj_generator obj_generator,
+    const EngineOptions& options,
+    int size) {
+  Handle<EnginePool> pool(new EnginePool(obj_generator, options, size));
+  return pool;
+}
+
+EnginePool::EnginePool(
+    jsc_obj_generator obj_generator,
+    const EngineOptions& options,
+    int size) : options_(options) {
+  obj_generator_ = obj_generator;
+  Start(size);
+}
+
+void EnginePool::Work() {
+  // Every JSGlobalContextCreate gets its own context group, engines on
+  // different threads do not share any JSC state.
+  Handle<Engine> engine = Engine::New(obj_generator_, options_);
+  bool tasks_posted = false;
+
+  Serve(engine, &tasks_posted);
+  engine.Clear();
+}
+
+#endif
+
+}  // namespace bastian
@@ -0,0 +1,110 @@
+// Copyright David Corticchiato
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef BASTIAN_POOL_H_
+#define BASTIAN_POOL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "./engine.h"
+#include "./handle.h"
+#include "./objcontext.h"
+#include "./value.h"
+
+
+namespace bastian {
+
+// Owns a fixed set of worker threads, each of them with its own isolate and
+// engine built from the same object generator. Run can be called from any
+// thread and is served by the first idle worker.
+//
+// Values returned by Run are built on the worker thread: numbers and strings
+// can be used freely, functions stay bound to the worker's isolate. They can
+// be dropped on any thread, even once the pool is gone.
+//
+// Every worker engine gets the given options, except for the isolate which
+// is the worker's own. Pooled contexts are filled while a worker is idle.
+class EnginePool : public ThreadSafeRefCounted {
+ public:
+#ifdef BASTIAN_V8
+  static Handle<EnginePool> New(v8_obj_generator obj_generator, int size = 0);
+  static Handle<EnginePool> New(
+    v8_obj_generator obj_generator,
+    const EngineOptions& options,
+    int size = 0);
+#endif
+
+#ifdef BASTIAN_JSC
+  static Handle<EnginePool> New(jsc_obj_generator obj_generator, int size = 0);
+  static Handle<EnginePool> New(
+    jsc_obj_generator obj_generator,
+    const EngineOptions& options,
+    int size = 0);
+#endif
+
+  ~EnginePool();
+  Handle<Value> Run(const char *);
+  int Size();
+
+ private:
+  struct Job {
+    const char * source;
+    Handle<Value> result;
+    bool done;
+  };
+
+#ifdef BASTIAN_V8
+  EnginePool(
+    v8_obj_generator obj_generator,
+    const EngineOptions& options,
+    int size);
+  v8_obj_generator obj_generator_;
+#endif
+
+#ifdef BASTIAN_JSC
+  EnginePool(
+    jsc_obj_generator obj_generator,
+    const EngineOptions& options,
+    int size);
+  jsc_obj_generator obj_generator_;
+#endif
+
+  EngineOptions options_;
+
+  void Start(int size);
+  void Work();
+  void Serve(Handle<Engine> engine, bool* tasks_posted);
+
+  std::vector<std::thread> workers_;
+  std::deque<Job*> jobs_;
+  std::mutex mutex_;
+  std::condition_variable job_ready_;
+  std::condition_variable job_done_;
+  bool stopping_;
+};
+
+}  // namespace bastian
+
+#endif  // BASTIAN_POOL_H_
@@ -0,0 +1,3 @@
+// Evaluated once at build time by mksnapshot, every context created by
+// bastian starts with the globals defined here. Build with
+// -Dbastian_prelude=<path> to bake another prelude in.
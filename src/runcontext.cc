@@ -29,7 +29,7 @@ namespace bastian {
 //
 
 
-Handle<RunContext> RunContext::current_(NULL);
+thread_local Handle<RunContext> RunContext::current_;
 
 Handle<RunContext> RunContext::GetCurrent() {
   return current_;
@@ -55,6 +55,10 @@ Handle<RunContext> RunContext::New(v8::Local<v8::Context> v8_context) {
 RunContext::RunContext(v8::Local<v8::Context> v8_context) {
   v8_context_.Reset(v8::Isolate::GetCurrent(), v8_context);
 }
+
+RunContext::~RunContext() {
+  v8_context_.Reset();
+}
 #endif
 
 
@@ -70,7 +74,18 @@ Handle<RunContext> RunContext::New(JSContextRef jsc_context) {
   return context;
 }
 
-RunContext::RunContext(JSContextRef jsc_context) : jsc_context_(jsc_context) {}
+// Retained so that values bound to the context can still be called once
+// the engine is done with it.
+RunContext::RunContext(JSContextRef jsc_context)
+  : jsc_context_(JSGlobalContextRetain(JSContextGetGlobalContext(jsc_context))) {}
+
+RunContext::~RunContext() {
+  JSGlobalContextRelease(jsc_context_);
+}
+
+JSGlobalContextRef RunContext::CurrentJSCContext() {
+  return current_->jsc_context_;
+}
 #endif
 
 }  // namespace bastian
\ No newline at end of file
@@ -23,6 +23,7 @@
 
 #include "./value.h"
 #include "./handle.h"
+#include "./persistent.h"
 
 #ifdef BASTIAN_V8
 #include <v8.h>
@@ -34,7 +35,7 @@
 
 namespace bastian {
 
-class RunContext {
+class RunContext : public RefCounted {
   friend class Function;
   friend class Object;
   friend class Value;
@@ -54,18 +55,26 @@ class RunContext {
   static Handle<RunContext> GetCurrent();
   static void SetCurrent(Handle<RunContext> current);
 
+#ifdef BASTIAN_JSC
+  // Global context of the current run, host values are made in it.
+  static JSGlobalContextRef CurrentJSCContext();
+#endif
+
+  ~RunContext();
+
  private:
 #ifdef BASTIAN_V8
-  v8::Persistent<v8::Context> v8_context_;
+  BoundPersistent<v8::Context> v8_context_;
   RunContext(v8::Local<v8::Context> v8_context);
 #endif
 
 #ifdef BASTIAN_JSC
-  JSContextRef jsc_context_;
+  JSGlobalContextRef jsc_context_;
   RunContext(JSContextRef jsc_context);
 #endif
 
-  static Handle<RunContext> current_;
+  // Each thread runs its own engine, the current context is per thread.
+  static thread_local Handle<RunContext> current_;
 };
 
 
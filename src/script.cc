@@ -0,0 +1,97 @@
+// Copyright David Corticchiato
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "./script.h"
+
+
+namespace bastian {
+
+//
+// V8 Script
+//
+
+
+#ifdef BASTIAN_V8
+
+Handle<Script> Script::New(
+    v8::Local<v8::UnboundScript> v8_script,
+    const char * source,
+    const char * name) {
+  Handle<Script> script(new Script(v8_script, source, name));
+  return script;
+}
+
+Script::Script(
+    v8::Local<v8::UnboundScript> v8_script,
+    const char * source,
+    const char * name)
+  : source_(source),
+    name_(name == NULL ? "" : name) {
+  v8_script_.Reset(v8::Isolate::GetCurrent(), v8_script);
+}
+
+Script::~Script() {
+  v8_script_.Reset();
+  v8_function_.Reset();
+}
+
+bool Script::IsValid() {
+  return !v8_script_.IsEmpty();
+}
+
+#endif
+
+
+//
+// JavascriptCore Script
+//
+
+
+#ifdef BASTIAN_JSC
+
+Handle<Script> Script::New(
+    JSStringRef jsc_source,
+    JSStringRef jsc_name,
+    bool valid) {
+  Handle<Script> script(new Script(jsc_source, jsc_name, valid));
+  return script;
+}
+
+Script::Script(JSStringRef jsc_source, JSStringRef jsc_name, bool valid)
+  : jsc_source_(JSStringRetain(jsc_source)),
+    jsc_name_(jsc_name),
+    valid_(valid) {}
+
+Script::~Script() {
+  JSStringRelease(jsc_source_);
+
+  if (jsc_name_ != NULL) {
+    JSStringRelease(jsc_name_);
+  }
+}
+
+bool Script::IsValid() {
+  return valid_;
+}
+
+#endif
+
+}  // namespace bastian
@@ -0,0 +1,92 @@
+// Copyright David Corticchiato
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef BASTIAN_SCRIPT_H_
+#define BASTIAN_SCRIPT_H_
+
+#include <string>
+
+#include "./handle.h"
+#include "./persistent.h"
+
+#ifdef BASTIAN_V8
+#include <v8.h>
+#endif
+
+#ifdef BASTIAN_JSC
+#include <JavascriptCore/JavascriptCore.h>
+#endif
+
+
+namespace bastian {
+
+// A script compiled by Engine::Compile, it can be run any number of times
+// by the engine that compiled it, each run gets a fresh context.
+//
+// Run with arguments, the source is the body of a function: arguments are
+// read through `arguments` and the result is given with `return`.
+class Script : public RefCounted {
+  friend class V8Engine;
+  friend class JSCEngine;
+
+ public:
+  ~Script();
+
+  // False when the source did not compile as a script, running it
+  // without arguments yields null.
+  bool IsValid();
+
+#ifdef BASTIAN_V8
+  static Handle<Script> New(
+    v8::Local<v8::UnboundScript> v8_script,
+    const char * source,
+    const char * name);
+#endif
+
+#ifdef BASTIAN_JSC
+  static Handle<Script> New(JSStringRef jsc_source, JSStringRef jsc_name, bool valid);
+#endif
+
+ private:
+#ifdef BASTIAN_V8
+  Script(
+    v8::Local<v8::UnboundScript> v8_script,
+    const char * source,
+    const char * name);
+  BoundPersistent<v8::UnboundScript> v8_script_;
+
+  // Compiled on the first run with arguments.
+  BoundPersistent<v8::UnboundScript> v8_function_;
+  std::string source_;
+  std::string name_;
+#endif
+
+#ifdef BASTIAN_JSC
+  Script(JSStringRef jsc_source, JSStringRef jsc_name, bool valid);
+  JSStringRef jsc_source_;
+  JSStringRef jsc_name_;
+  bool valid_;
+#endif
+};
+
+}  // namespace bastian
+
+#endif  // BASTIAN_SCRIPT_H_
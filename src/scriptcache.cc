@@ -0,0 +1,332 @@
+// Copyright David Corticchiato
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "./scriptcache.h"
+
+#include <stdint.h>
+#include <cstring>
+
+
+namespace bastian {
+
+//
+// Common ScriptCache
+//
+
+
+ScriptCache::ScriptCache(size_t budget, const std::string& code_cache_dir)
+  : budget_(budget), code_cache_(code_cache_dir) {
+  std::memset(&stats_, 0, sizeof(stats_));
+}
+
+ScriptCache::~ScriptCache() {
+  Clear();
+}
+
+void ScriptCache::SetBudget(size_t budget) {
+  budget_ = budget;
+  Trim();
+}
+
+void ScriptCache::Clear() {
+  while (!lru_.empty()) {
+    Evict(--lru_.end());
+  }
+}
+
+script_cache_stats ScriptCache::Stats() {
+  stats_.entries = lru_.size();
+  return stats_;
+}
+
+// FNV-1a, hashing the raw bytes avoids building a std::string on hits.
+size_t ScriptCache::Hash(
+    const char * name,
+    const char * source,
+    size_t length) {
+  uint64_t hash = 14695981039346656037ULL;
+
+  // The terminating zero of the name separates it from the source.
+  do {
+    hash ^= static_cast<unsigned char>(*name);
+    hash *= 1099511628211ULL;
+  } while (*name++ != '\0');
+
+  for (size_t index = 0; index < length; ++index) {
+    hash ^= static_cast<unsigned char>(source[index]);
+    hash *= 1099511628211ULL;
+  }
+
+  return static_cast<size_t>(hash);
+}
+
+ScriptCache::Entry* ScriptCache::Lookup(
+    size_t hash,
+    const char * name,
+    const char * source,
+    size_t length) {
+  std::unordered_map<size_t, EntryList::iterator>::iterator found =
+    index_.find(hash);
+
+  if (found == index_.end()) {
+    stats_.misses++;
+    return NULL;
+  }
+
+  Entry* entry = *found->second;
+
+  if (entry->source.size() != length
+      || entry->name != name
+      || std::memcmp(entry->source.data(), source, length) != 0) {
+    // Hash collision, the new script takes the slot.
+    Evict(found->second);
+    stats_.misses++;
+    return NULL;
+  }
+
+  lru_.splice(lru_.begin(), lru_, found->second);
+  stats_.hits++;
+
+  return entry;
+}
+
+void ScriptCache::Insert(Entry* entry) {
+  lru_.push_front(entry);
+  index_[entry->hash] = lru_.begin();
+  stats_.bytes += entry->source.size();
+
+  Trim();
+}
+
+void ScriptCache::Evict(EntryList::iterator position) {
+  Entry* entry = *position;
+
+  index_.erase(entry->hash);
+  lru_.erase(position);
+  stats_.bytes -= entry->source.size();
+
+#ifdef BASTIAN_V8
+  entry->script.Reset();
+#endif
+#ifdef BASTIAN_JSC
+  JSStringRelease(entry->script);
+#endif
+
+  delete entry;
+}
+
+void ScriptCache::Trim() {
+  // The most recent entry is kept even when it is over budget on its own.
+  while (stats_.bytes > budget_ && lru_.size() > 1) {
+    Evict(--lru_.end());
+    stats_.evictions++;
+  }
+}
+
+
+//
+// V8 ScriptCache
+//
+
+
+#ifdef BASTIAN_V8
+
+// Function bodies start on a line of their own, the origin is moved one
+// line up so that errors point into the body.
+static const char kFunctionHead[] = "(function () {\n";
+static const char kFunctionTail[] = "\n})";
+
+// A body closing the wrapper early would run outside of it. The Function
+// constructor of the current context only accepts a body parsing as a
+// single function.
+static bool IsFunctionBody(
+    v8::Isolate* isolate,
+    const char * body,
+    size_t length) {
+  v8::Local<v8::Value> constructor =
+    isolate->GetCurrentContext()->Global()->Get(
+      v8::String::NewFromUtf8(isolate, "Function"));
+  v8::Local<v8::Value> argument = v8::String::NewFromUtf8(
+    isolate, body, v8::String::kNormalString, static_cast<int>(length));
+
+  return !constructor.As<v8::Function>()->NewInstance(1, &argument).IsEmpty();
+}
+
+v8::Local<v8::UnboundScript> ScriptCache::Get(
+    const char * name,
+    const char * source,
+    size_t length) {
+  return Find(name, source, length, false);
+}
+
+v8::Local<v8::UnboundScript> ScriptCache::GetFunction(
+    const char * name,
+    const char * body,
+    size_t length) {
+  std::string wrapped(kFunctionHead);
+
+  wrapped.append(body, length);
+  wrapped.append(kFunctionTail);
+
+  return Find(name, wrapped.data(), wrapped.size(), true);
+}
+
+v8::Local<v8::UnboundScript> ScriptCache::Find(
+    const char * name,
+    const char * source,
+    size_t length,
+    bool function) {
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+
+  if (name == NULL) {
+    name = "";
+  }
+
+  size_t hash = Hash(name, source, length);
+  Entry* entry = Lookup(hash, name, source, length);
+
+  if (entry != NULL) {
+    return v8::Local<v8::UnboundScript>::New(isolate, entry->script);
+  }
+
+  v8::TryCatch try_catch;
+  v8::Local<v8::UnboundScript> script;
+  size_t head = sizeof(kFunctionHead) - 1;
+  size_t tail = sizeof(kFunctionTail) - 1;
+
+  if (!function || IsFunctionBody(
+      isolate, source + head, length - head - tail)) {
+    script = Compile(
+      v8::String::NewFromUtf8(
+        isolate, source, v8::String::kNormalString, static_cast<int>(length)),
+      name,
+      function ? -1 : 0,
+      hash,
+      source,
+      length);
+  }
+
+  // Failures get an empty entry, the same source is not compiled again.
+  entry = new Entry();
+  entry->hash = hash;
+  entry->name = name;
+  entry->source.assign(source, length);
+  entry->script.Reset(isolate, script);
+  Insert(entry);
+
+  return script;
+}
+
+v8::Local<v8::UnboundScript> ScriptCache::Compile(
+    v8::Local<v8::String> source_string,
+    const char * name,
+    int line_offset,
+    size_t hash,
+    const char * source,
+    size_t length) {
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::Local<v8::UnboundScript> script;
+  v8::Local<v8::Value> name_string;
+  code_cache_blob blob;
+
+  if (*name != '\0') {
+    name_string = v8::String::NewFromUtf8(isolate, name);
+  }
+
+  v8::ScriptOrigin origin(
+    name_string, v8::Integer::New(isolate, line_offset));
+
+  if (!code_cache_.Enabled()) {
+    v8::ScriptCompiler::Source script_source(source_string, origin);
+    return v8::ScriptCompiler::CompileUnbound(isolate, &script_source);
+  }
+
+  if (code_cache_.Load(hash, source, length, &blob)) {
+    // The mapping is only read while compiling, the Source owns the
+    // CachedData but not its buffer.
+    v8::ScriptCompiler::Source script_source(
+      source_string,
+      origin,
+      new v8::ScriptCompiler::CachedData(
+        blob.data, static_cast<int>(blob.length)));
+    script = v8::ScriptCompiler::CompileUnbound(
+      isolate, &script_source, v8::ScriptCompiler::kConsumeCodeCache);
+    code_cache_.Release(&blob);
+
+    // Otherwise compiled from the source, and the blob written again.
+    if (!script.IsEmpty()) {
+      stats_.code_cache_loads++;
+      return script;
+    }
+  }
+
+  v8::ScriptCompiler::Source script_source(source_string, origin);
+  script = v8::ScriptCompiler::CompileUnbound(
+    isolate, &script_source, v8::ScriptCompiler::kProduceCodeCache);
+
+  const v8::ScriptCompiler::CachedData* data = script_source.GetCachedData();
+
+  if (!script.IsEmpty() && data != NULL && code_cache_.Store(
+      hash, source, length, data->data, static_cast<size_t>(data->length))) {
+    stats_.code_cache_stores++;
+  }
+
+  return script;
+}
+
+#endif
+
+
+//
+// JavascriptCore ScriptCache
+//
+
+
+#ifdef BASTIAN_JSC
+
+// JSC has no public API for compiled scripts, the cache saves the UTF-8 to
+// UTF-16 conversion of the source.
+JSStringRef ScriptCache::Get(
+    const char * name,
+    const char * source,
+    size_t length) {
+  if (name == NULL) {
+    name = "";
+  }
+
+  size_t hash = Hash(name, source, length);
+  Entry* entry = Lookup(hash, name, source, length);
+
+  if (entry == NULL) {
+    entry = new Entry();
+    entry->hash = hash;
+    entry->name = name;
+    entry->source.assign(source, length);
+    entry->script = JSStringCreateWithUTF8CString(entry->source.c_str());
+    Insert(entry);
+  }
+
+  return entry->script;
+}
+
+#endif
+
+}  // namespace bastian
@@ -0,0 +1,139 @@
+// Copyright David Corticchiato
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef BASTIAN_SCRIPTCACHE_H_
+#define BASTIAN_SCRIPTCACHE_H_
+
+#include <cstddef>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include "./codecache.h"
+
+#ifdef BASTIAN_V8
+#include <v8.h>
+#endif
+
+#ifdef BASTIAN_JSC
+#include <JavascriptCore/JavascriptCore.h>
+#endif
+
+
+namespace bastian {
+
+typedef struct t_script_cache_stats {
+  size_t hits;
+  size_t misses;
+  // Entries dropped to stay within the budget.
+  size_t evictions;
+  size_t entries;
+  size_t bytes;
+  size_t code_cache_loads;
+  size_t code_cache_stores;
+} script_cache_stats;
+
+// Compiled scripts of an engine, keyed by a hash of their name and source,
+// evicted in least recently used order once the byte budget is exceeded.
+// The budget is counted in source bytes, V8 does not expose the size of
+// the compiled code. Misses go through the on-disk code cache when a
+// directory is given.
+class ScriptCache {
+ public:
+  ScriptCache(size_t budget, const std::string& code_cache_dir);
+  ~ScriptCache();
+
+  // The name is the script origin reported in stack traces, it can be NULL.
+#ifdef BASTIAN_V8
+  // Returns an empty handle when the source does not compile, failures
+  // are cached too and never reported.
+  v8::Local<v8::UnboundScript> Get(
+      const char * name,
+      const char * source,
+      size_t length);
+
+  // Same for the body of a function without parameters, running the
+  // returned script evaluates to the function.
+  v8::Local<v8::UnboundScript> GetFunction(
+      const char * name,
+      const char * body,
+      size_t length);
+#endif
+
+#ifdef BASTIAN_JSC
+  JSStringRef Get(const char * name, const char * source, size_t length);
+#endif
+
+  void SetBudget(size_t budget);
+  void Clear();
+  script_cache_stats Stats();
+
+  static size_t Hash(const char * name, const char * source, size_t length);
+
+ private:
+  struct Entry {
+    size_t hash;
+    std::string name;
+    std::string source;
+#ifdef BASTIAN_V8
+    v8::Persistent<v8::UnboundScript> script;
+#endif
+#ifdef BASTIAN_JSC
+    JSStringRef script;
+#endif
+  };
+
+  typedef std::list<Entry*> EntryList;
+
+#ifdef BASTIAN_V8
+  v8::Local<v8::UnboundScript> Find(
+      const char * name,
+      const char * source,
+      size_t length,
+      bool function);
+  v8::Local<v8::UnboundScript> Compile(
+      v8::Local<v8::String> source_string,
+      const char * name,
+      int line_offset,
+      size_t hash,
+      const char * source,
+      size_t length);
+#endif
+
+  Entry* Lookup(
+      size_t hash,
+      const char * name,
+      const char * source,
+      size_t length);
+  void Insert(Entry* entry);
+  void Evict(EntryList::iterator position);
+  void Trim();
+
+  EntryList lru_;
+  std::unordered_map<size_t, EntryList::iterator> index_;
+  size_t budget_;
+  script_cache_stats stats_;
+  CodeCache code_cache_;
+};
+
+}  // namespace bastian
+
+#endif  // BASTIAN_SCRIPTCACHE_H_
@@ -20,9 +20,15 @@
 
 #include "./value.h"
 
+#include "./callsite.h"
 #include "./objcontext.h"
+#include "./platform.h"
 #include "./runcontext.h"
 #include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
 
 
 namespace bastian {
@@ -32,6 +38,18 @@ namespace bastian {
 //
 
 
+bool Value::IsArray() {
+  return type_ == ARRAY;
+}
+
+bool Value::IsArrayBuffer() {
+  return type_ == ARRAY_BUFFER;
+}
+
+bool Value::IsBoolean() {
+  return type_ == BOOLEAN;
+}
+
 bool Value::IsFunction() {
   return type_ == FUNCTION;
 }
@@ -44,29 +62,110 @@ bool Value::IsNull() {
   return type_ == NUL;
 }
 
+bool Value::IsObject() {
+  return type_ == OBJECT;
+}
+
 bool Value::IsString() {
   return type_ == STRING;
 }
 
+bool Value::IsTypedArray() {
+  return type_ == FLOAT64_ARRAY || type_ == INT32_ARRAY || type_ == UINT8_ARRAY;
+}
+
 bool Value::IsUndefined() {
   return type_ == UNDEFINED;
 }
 
+string_view Value::StringView() {
+  string_view view = { "", 0 };
+  return view;
+}
+
+Handle<Value> Value::FromVector(const std::vector<double>& values) {
+  Handle<Value> array = Float64Array::New(values.size());
+
+  if (!values.empty()) {
+    std::memcpy(
+      Float64Array::Cast(array)->Data(),
+      values.data(),
+      values.size() * sizeof(double));
+  }
+
+  return array;
+}
+
 
 //
 // Common NullValue
 //
 
 
+// The primitive values are built in the storage of the handle, which is
+// sized for a Number.
+static_assert(sizeof(NullValue) <= sizeof(Number), "NullValue is inlined");
+static_assert(sizeof(UndefinedValue) <= sizeof(Number),
+  "UndefinedValue is inlined");
+static_assert(sizeof(Boolean) <= sizeof(Number), "Boolean is inlined");
+
 NullValue::NullValue() {
   type_ = NUL;
 }
 
 Handle<Value> NullValue::New() {
-  Handle<Value> value(reinterpret_cast<Value*>(new NullValue()));
+  Handle<Value> value;
+  new (value.Storage()) NullValue();
+  return value;
+}
+
+Value* NullValue::CloneInto(void* storage) {
+  return new (storage) NullValue();
+}
+
+//
+// Common UndefinedValue
+//
+
+
+UndefinedValue::UndefinedValue() {
+  type_ = UNDEFINED;
+}
+
+Handle<Value> UndefinedValue::New() {
+  Handle<Value> value;
+  new (value.Storage()) UndefinedValue();
+  return value;
+}
+
+Value* UndefinedValue::CloneInto(void* storage) {
+  return new (storage) UndefinedValue();
+}
+
+//
+// Common Boolean
+//
+
+
+Boolean::Boolean(bool val) {
+  type_ = BOOLEAN;
+  val_ = val;
+}
+
+bool Boolean::BooleanValue() {
+  return val_;
+}
+
+Handle<Value> Boolean::New(bool val) {
+  Handle<Value> value;
+  new (value.Storage()) Boolean(val);
   return value;
 }
 
+Value* Boolean::CloneInto(void* storage) {
+  return new (storage) Boolean(val_);
+}
+
 //
 // Common Number
 //
@@ -82,10 +181,15 @@ double Number::NumberValue() {
 }
 
 Handle<Value> Number::New(double val) {
-  Handle<Value> value(reinterpret_cast<Value*>(new Number(val)));
+  Handle<Value> value;
+  new (value.Storage()) Number(val);
   return value;
 }
 
+Value* Number::CloneInto(void* storage) {
+  return new (storage) Number(val_);
+}
+
 //
 // Common String
 //
@@ -96,8 +200,13 @@ String::String(const std::string& val) {
   val_ = val;
 }
 
+String::String() {
+  type_ = STRING;
+}
+
 std::string String::StringValue() {
-  return val_;
+  string_view view = StringView();
+  return std::string(view.data, view.length);
 }
 
 Handle<Value> String::New(const std::string& val) {
@@ -105,237 +214,1785 @@ Handle<Value> String::New(const std::string& val) {
   return value;
 }
 
+Handle<Value> String::NewExternal(Handle<ExternalBuffer> buffer) {
+  String* string = new String();
 
-//
-// V8 Value
-//
+  string->external_ = buffer;
 
+  Handle<Value> value(reinterpret_cast<Value*>(string));
+  return value;
+}
 
-#ifdef BASTIAN_V8
+Handle<Value> String::NewExternal(
+    const char * data,
+    size_t length,
+    ExternalBuffer::release_callback release,
+    void* user_data) {
+  return NewExternal(ExternalBuffer::New(data, length, release, user_data));
+}
 
-Handle<Value> Value::New(const v8::Local<v8::Value>& v8_value) {
-  Handle<Value> result = bastian::NullValue::New();
-  v8::Local<v8::String> v8_string;
-  char* utf8_buffer;
-  int str_size;
+static void DeleteString(void* user_data) {
+  delete static_cast<std::string*>(user_data);
+}
 
-  if (v8_value->IsNumber()) {
-    result = Number::New(v8_value->NumberValue());
-  } else if (v8_value->IsString()) {
-    v8_string = v8_value->ToString();
-    str_size = v8_string->Utf8Length() + 1;
-    utf8_buffer = static_cast<char*>(std::malloc(str_size));
-    v8_string->WriteUtf8(utf8_buffer, str_size);
-    result = String::New(utf8_buffer);
-    std::free(utf8_buffer);
-  } else if (v8_value->IsFunction()) {
-    result = Function::New(v8::Local<v8::Function>::Cast(v8_value));
-  }
+Handle<Value> String::NewExternal(std::string&& val) {
+  std::string* owned = new std::string(std::move(val));
 
-  return result;
+  return NewExternal(owned->data(), owned->size(), DeleteString, owned);
 }
 
-v8::Local<v8::Value> Value::Extract() {
-  v8::Local<v8::Value> result;
+//
+// Common ExternalBuffer
+//
 
-  if (IsNumber()) {
-    result = v8::Number::New(
-      v8::Isolate::GetCurrent(),
-      NumberValue());
-  } else if (IsString()) {
-    result = v8::String::NewFromUtf8(
-      v8::Isolate::GetCurrent(),
-      StringValue().c_str());
-  }
 
-  return result;
+ExternalBuffer::ExternalBuffer(
+    char * data,
+    size_t length,
+    release_callback release,
+    void* user_data)
+  : data_(data),
+    length_(length),
+    release_(release),
+    user_data_(user_data),
+    encoding_(ENCODING_UNKNOWN) {}
+
+ExternalBuffer::~ExternalBuffer() {
+  if (release_ != NULL) {
+    release_(user_data_);
+  }
 }
 
-#endif
-
-//
-// JavascriptCore Value
-//
+Handle<ExternalBuffer> ExternalBuffer::New(
+    const char * data,
+    size_t length,
+    release_callback release,
+    void* user_data) {
+  Handle<ExternalBuffer> buffer(new ExternalBuffer(
+    const_cast<char *>(data), length, release, user_data));
+  return buffer;
+}
 
+Handle<ExternalBuffer> ExternalBuffer::New(
+    void* data,
+    size_t length,
+    release_callback release,
+    void* user_data) {
+  Handle<ExternalBuffer> buffer(new ExternalBuffer(
+    static_cast<char *>(data), length, release, user_data));
+  return buffer;
+}
 
-#ifdef BASTIAN_JSC
+const char * ExternalBuffer::Data() {
+  return data_;
+}
 
-Handle<Value> Value::New(JSValueRef jsc_value) {
-  /****/
-  Handle<Value> result = NullValue::New();
-  JSStringRef jsc_string;
-  JSObjectRef jsc_object;
-  int str_size;
-  char* utf8_buffer;
-  JSValueRef* exception_ref = 0;
+void* ExternalBuffer::Bytes() {
+  return data_;
+}
 
-  JSContextRef context_ref = RunContext::GetCurrent()->jsc_context_;
+size_t ExternalBuffer::Length() {
+  return length_;
+}
 
-  if (JSValueIsNumber(context_ref, jsc_value)) {
-    result = Number::New(JSValueToNumber(
-      context_ref,
-      jsc_value,
-      exception_ref));
-  } else if (JSValueIsString(context_ref, jsc_value)) {
-    jsc_string = JSValueToStringCopy(
-      context_ref,
-      jsc_value,
-      exception_ref);
+bool ExternalBuffer::IsAscii() {
+  int encoding = encoding_.load(std::memory_order_relaxed);
 
-    str_size = JSStringGetLength(jsc_string) + 1;
-    utf8_buffer = static_cast<char*>(std::malloc(str_size));
-    JSStringGetUTF8CString(jsc_string, utf8_buffer, str_size);
-    result = String::New(utf8_buffer);
-    std::free(utf8_buffer);
-  } else if (JSValueIsObject(context_ref, jsc_value)) {
-    jsc_object = JSValueToObject(context_ref, jsc_value, NULL);
+  if (encoding == ENCODING_UNKNOWN) {
+    encoding = ENCODING_ASCII;
 
-    if (JSObjectIsFunction(context_ref, jsc_object)) {
-      result = Function::New(jsc_object);
+    for (size_t index = 0; index < length_; ++index) {
+      if (static_cast<unsigned char>(data_[index]) >= 0x80) {
+        encoding = ENCODING_OTHER;
+        break;
+      }
     }
+
+    encoding_.store(encoding, std::memory_order_relaxed);
   }
 
-  return result;
+  return encoding == ENCODING_ASCII;
 }
 
-JSValueRef Value::Extract() {
-  JSValueRef result;
-  JSContextRef context_ref = RunContext::GetCurrent()->jsc_context_;
+//
+// Common Array
+//
 
 
-  if (IsNumber()) {
-    result = JSValueMakeNumber(context_ref, NumberValue());
-  } else if (IsString()) {
-    result = JSValueMakeString(
-      context_ref,
-      JSStringCreateWithUTF8CString(StringValue().c_str()));
-  } else {
-    result = JSValueMakeNull(context_ref);
+Array::Array(const std::vector<Handle<Value>>& elements)
+  : elements_(elements) {
+  type_ = ARRAY;
+#ifdef BASTIAN_JSC
+  jsc_object_ = NULL;
+  jsc_context_ = NULL;
+#endif
+}
+
+Handle<Value> Array::New(const std::vector<Handle<Value>>& elements) {
+  Handle<Value> value(reinterpret_cast<Value*>(new Array(elements)));
+  return value;
+}
+
+Array* Array::Cast(const Handle<Value>& value) {
+  if (!value->IsArray()) {
+    return NULL;
   }
 
-  return result;
+  return static_cast<Array*>(value.operator->());
 }
 
-#endif
+static double ElementNumber(const Handle<Value>& element) {
+  if (!element->IsNumber()) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
 
+  return element->NumberValue();
+}
 
 //
-// V8 Function
+// Common ArrayBuffer
 //
 
-#ifdef BASTIAN_V8
 
-Function::Function(const v8::Local<v8::Function>& v8_function) {
-  v8_function_.Reset(v8::Isolate::GetCurrent(), v8_function);
-  type_ = FUNCTION;
+static void FreeBytes(void* user_data) {
+  std::free(user_data);
 }
 
-Handle<Value> Function::New(const v8::Local<v8::Function>& v8_function) {
-  Handle<Value> function(reinterpret_cast<Value*>(new Function (v8_function)));
-  return function;
+// Zero filled memory released with the buffer.
+static Handle<ExternalBuffer> NewBytes(size_t count, size_t size) {
+  void* data = std::calloc(count > 0 ? count : 1, size);
+
+  if (data == NULL) {
+    std::abort();
+  }
+
+  return ExternalBuffer::New(data, count * size, FreeBytes, data);
 }
 
-void Function::Call(const std::vector<Handle<Value>>& arguments) {
-  v8::Local<v8::Value> * args = static_cast<v8::Local<v8::Value> *> (malloc(arguments.size() * sizeof(v8::Local<v8::Value>)));
+Handle<Value> ArrayBuffer::New(size_t byte_length) {
+  return New(NewBytes(byte_length, 1));
+}
 
-  v8::Local<v8::Function> function = v8::Local<v8::Function>::New(v8::Isolate::GetCurrent(), v8_function_);
-  v8::Local<v8::Context> context =  v8::Local<v8::Context>::New(v8::Isolate::GetCurrent(), RunContext::GetCurrent()->v8_context_); 
+Handle<Value> ArrayBuffer::New(Handle<ExternalBuffer> buffer) {
+  Handle<Value> value(reinterpret_cast<Value*>(new ArrayBuffer(buffer)));
+  return value;
+}
 
-  for (unsigned index = 0; index < arguments.size(); ++index) {
-    args[index] = arguments.at(index)->Extract();
+ArrayBuffer* ArrayBuffer::Cast(const Handle<Value>& value) {
+  if (!value->IsArrayBuffer()) {
+    return NULL;
   }
 
-  function->Call(context->Global(), arguments.size(), args);
+  return static_cast<ArrayBuffer*>(value.operator->());
+}
 
-  free(args);
+Handle<ExternalBuffer> ArrayBuffer::Buffer() {
+  return buffer_;
 }
 
-#endif
+void* ArrayBuffer::Data() {
+  return buffer_->Bytes();
+}
+
+size_t ArrayBuffer::ByteLength() {
+  return buffer_->Length();
+}
 
 //
-// JSC Function
+// Common TypedArray
 //
 
+
+TypedArray::TypedArray(
+    Type type,
+    Handle<ExternalBuffer> buffer,
+    size_t byte_offset,
+    size_t length)
+  : buffer_(buffer),
+    byte_offset_(byte_offset),
+    length_(length) {
+  type_ = type;
 #ifdef BASTIAN_JSC
+  jsc_object_ = NULL;
+  jsc_context_ = NULL;
+#endif
+}
 
-Function::Function(JSObjectRef jsc_object) : jsc_object_(jsc_object) {
-  type_ = FUNCTION;
+size_t TypedArray::ElementSize(Type type) {
+  switch (type) {
+    case FLOAT64_ARRAY:
+      return sizeof(double);
+    case INT32_ARRAY:
+      return sizeof(int32_t);
+    default:
+      return sizeof(uint8_t);
+  }
 }
 
-Handle<Value> Function::New(JSObjectRef jsc_object) {
-  Handle<Value> function(reinterpret_cast<Value*>(new Function (jsc_object)));
-  return function;
+Handle<Value> TypedArray::New(
+    Type type,
+    Handle<ExternalBuffer> buffer,
+    size_t byte_offset,
+    size_t length) {
+  size_t element_size = ElementSize(type);
+
+  if (byte_offset % element_size != 0 ||
+      byte_offset > buffer->Length() ||
+      length > (buffer->Length() - byte_offset) / element_size) {
+    return NullValue::New();
+  }
+
+  TypedArray* array;
+
+  switch (type) {
+    case FLOAT64_ARRAY:
+      array = new Float64Array(buffer, byte_offset, length);
+      break;
+    case INT32_ARRAY:
+      array = new Int32Array(buffer, byte_offset, length);
+      break;
+    default:
+      array = new Uint8Array(buffer, byte_offset, length);
+      break;
+  }
+
+  Handle<Value> value(array);
+  return value;
 }
 
-void Function::Call(const std::vector<Handle<Value>>& arguments) {
-  /* Generate void context for function */
+TypedArray* TypedArray::Cast(const Handle<Value>& value, Type type) {
+  TypedArray* array = static_cast<TypedArray*>(value.operator->());
 
-  JSValueRef * args = static_cast<JSValueRef *> (malloc(arguments.size() * sizeof(JSValueRef)));
-  JSContextRef context_ref = RunContext::GetCurrent()->jsc_context_;
+  if (!value->IsTypedArray() || array->type_ != type) {
+    return NULL;
+  }
 
-  JSValueRef* exception = 0;
-  JSObjectRef global = JSContextGetGlobalObject(context_ref);
+  return array;
+}
 
-  for (unsigned index = 0; index < arguments.size(); ++index) {
-    args[index] = arguments.at(index)->Extract();
+bool TypedArray::ToVector(std::vector<double>* values) {
+  switch (type_) {
+    case FLOAT64_ARRAY: {
+      const double* elements = static_cast<double*>(Elements());
+      values->assign(elements, elements + length_);
+      break;
+    }
+    case INT32_ARRAY: {
+      const int32_t* elements = static_cast<int32_t*>(Elements());
+      values->assign(elements, elements + length_);
+      break;
+    }
+    default: {
+      const uint8_t* elements = static_cast<uint8_t*>(Elements());
+      values->assign(elements, elements + length_);
+      break;
+    }
   }
 
-  JSObjectCallAsFunction(context_ref, jsc_object_, global, arguments.size(), args, exception);
+  return true;
+}
 
-  free(args);
+Handle<ExternalBuffer> TypedArray::Buffer() {
+  return buffer_;
 }
 
-#endif
+size_t TypedArray::ByteOffset() {
+  return byte_offset_;
+}
 
+size_t TypedArray::Length() {
+  return length_;
+}
 
-//
-// V8 Object
-//
+void* TypedArray::Elements() {
+  return static_cast<char *>(buffer_->Bytes()) + byte_offset_;
+}
 
-#ifdef BASTIAN_V8
+Float64Array::Float64Array(
+    Handle<ExternalBuffer> buffer,
+    size_t byte_offset,
+    size_t length)
+  : TypedArray(FLOAT64_ARRAY, buffer, byte_offset, length) {}
 
-Handle<Value> Object::New(void (*obj_generator)(Handle<V8ObjectContext>)) {
-  Handle<Value> value(reinterpret_cast<Value*>(new Object(obj_generator)));
-  return value;
+Handle<Value> Float64Array::New(size_t length) {
+  return New(NewBytes(length, sizeof(double)), 0, length);
 }
 
-Object::Object(void (*obj_generator)(Handle<V8ObjectContext>)) {
-  Handle<V8ObjectContext> object_context = V8ObjectContext::New();
-  obj_generator(object_context);
-  v8::Local<v8::Object> local_instance = object_context->ObjectTemplate()->NewInstance();
-  v8_object_.Reset(v8::Isolate::GetCurrent(), local_instance);
+Handle<Value> Float64Array::New(
+    Handle<ExternalBuffer> buffer,
+    size_t byte_offset,
+    size_t length) {
+  return TypedArray::New(FLOAT64_ARRAY, buffer, byte_offset, length);
 }
 
-v8::Local<v8::Value> Object::Extract() {
-  v8::Local<v8::Object> local_instance = v8::Local<v8::Object>::New(v8::Isolate::GetCurrent(), v8_object_);
-  return local_instance;
+Float64Array* Float64Array::Cast(const Handle<Value>& value) {
+  return static_cast<Float64Array*>(TypedArray::Cast(value, FLOAT64_ARRAY));
 }
 
+double* Float64Array::Data() {
+  return static_cast<double*>(Elements());
+}
 
-#endif
+Int32Array::Int32Array(
+    Handle<ExternalBuffer> buffer,
+    size_t byte_offset,
+    size_t length)
+  : TypedArray(INT32_ARRAY, buffer, byte_offset, length) {}
+
+Handle<Value> Int32Array::New(size_t length) {
+  return New(NewBytes(length, sizeof(int32_t)), 0, length);
+}
+
+Handle<Value> Int32Array::New(
+    Handle<ExternalBuffer> buffer,
+    size_t byte_offset,
+    size_t length) {
+  return TypedArray::New(INT32_ARRAY, buffer, byte_offset, length);
+}
+
+Int32Array* Int32Array::Cast(const Handle<Value>& value) {
+  return static_cast<Int32Array*>(TypedArray::Cast(value, INT32_ARRAY));
+}
+
+int32_t* Int32Array::Data() {
+  return static_cast<int32_t*>(Elements());
+}
+
+Uint8Array::Uint8Array(
+    Handle<ExternalBuffer> buffer,
+    size_t byte_offset,
+    size_t length)
+  : TypedArray(UINT8_ARRAY, buffer, byte_offset, length) {}
+
+Handle<Value> Uint8Array::New(size_t length) {
+  return New(NewBytes(length, sizeof(uint8_t)), 0, length);
+}
+
+Handle<Value> Uint8Array::New(
+    Handle<ExternalBuffer> buffer,
+    size_t byte_offset,
+    size_t length) {
+  return TypedArray::New(UINT8_ARRAY, buffer, byte_offset, length);
+}
+
+Uint8Array* Uint8Array::Cast(const Handle<Value>& value) {
+  return static_cast<Uint8Array*>(TypedArray::Cast(value, UINT8_ARRAY));
+}
+
+uint8_t* Uint8Array::Data() {
+  return static_cast<uint8_t*>(Elements());
+}
 
 
 //
-// JSC Object
+// V8 Value
 //
 
 
-#ifdef BASTIAN_JSC
+#ifdef BASTIAN_V8
 
-Handle<Value> Object::New(void (*jsc_obj_generator)(Handle<JSCObjectContext>)) {
-  Handle<Value> value(reinterpret_cast<Value*>(new Object(jsc_obj_generator)));
-  return value;
+// An empty handle, left by an operation which threw, is undefined.
+Handle<Value> Value::New(const v8::Local<v8::Value>& v8_value) {
+  Handle<Value> result = bastian::NullValue::New();
+
+  if (v8_value.IsEmpty()) {
+    result = UndefinedValue::New();
+  } else if (v8_value->IsNumber()) {
+    result = Number::New(v8_value->NumberValue());
+  } else if (v8_value->IsBoolean()) {
+    result = Boolean::New(v8_value->BooleanValue());
+  } else if (v8_value->IsUndefined()) {
+    result = UndefinedValue::New();
+  } else if (v8_value->IsString()) {
+    result = String::Copy(v8::Local<v8::String>::Cast(v8_value));
+  } else if (v8_value->IsArrayBuffer()) {
+    result = ArrayBuffer::New(v8::Local<v8::ArrayBuffer>::Cast(v8_value));
+  } else if (v8_value->IsTypedArray()) {
+    result = TypedArray::New(v8::Local<v8::TypedArray>::Cast(v8_value));
+  } else if (v8_value->IsArray()) {
+    result = Array::New(v8::Local<v8::Array>::Cast(v8_value));
+  } else if (v8_value->IsFunction()) {
+    result = Function::New(v8::Local<v8::Function>::Cast(v8_value));
+  } else if (v8_value->IsObject()) {
+    result = Object::New(v8::Local<v8::Object>::Cast(v8_value));
+  }
+
+  return result;
 }
 
-Object::Object(void (*jsc_obj_generator)(Handle<JSCObjectContext>)) {
-  Handle<JSCObjectContext> object_context = JSCObjectContext::New();
-  jsc_obj_generator(object_context);
-  object_context->Build("Native Object");
-  jsc_object_ = object_context->object_ref_;
+v8::Local<v8::Value> Value::Extract() {
+  v8::Local<v8::Value> result;
+
+  if (IsNumber()) {
+    result = v8::Number::New(
+      v8::Isolate::GetCurrent(),
+      NumberValue());
+  } else if (IsString()) {
+    result = v8::String::NewFromUtf8(
+      v8::Isolate::GetCurrent(),
+      StringValue().c_str());
+  } else if (IsBoolean()) {
+    result = v8::Boolean::New(v8::Isolate::GetCurrent(), BooleanValue());
+  } else if (IsUndefined()) {
+    result = v8::Undefined(v8::Isolate::GetCurrent());
+  } else {
+    result = v8::Null(v8::Isolate::GetCurrent());
+  }
+
+  return result;
 }
 
-JSValueRef Object::Extract() {
-  return static_cast<JSValueRef>(jsc_object_);
+#endif
+
+//
+// V8 String
+//
+
+
+#ifdef BASTIAN_V8
+
+// Reused by the string views of the thread.
+static thread_local std::vector<char> string_view_buffer;
+
+Handle<Value> String::Copy(const v8::Local<v8::String>& v8_string) {
+  String* string = new String();
+  int length = v8_string->Utf8Length();
+
+  string->val_.resize(length);
+
+  if (length > 0) {
+    v8_string->WriteUtf8(
+      &string->val_[0], length, NULL, v8::String::NO_NULL_TERMINATION);
+  }
+
+  Handle<Value> value(reinterpret_cast<Value*>(string));
+  return value;
+}
+
+Handle<Value> String::Wrap(const v8::Local<v8::String>& v8_string) {
+  String* string = new String();
+
+  string->v8_string_.Reset(v8::Isolate::GetCurrent(), v8_string);
+
+  Handle<Value> value(reinterpret_cast<Value*>(string));
+  return value;
+}
+
+void String::Unwrap(const Handle<Value>& value) {
+  if (!value->IsString() || value->HasOneRef()) {
+    return;
+  }
+
+  String* string = reinterpret_cast<String*>(value.operator->());
+
+  if (string->v8_string_.IsEmpty()) {
+    return;
+  }
+
+  string_view view = string->StringView();
+
+  string->val_.assign(view.data, view.length);
+  string->v8_string_.Reset();
+}
+
+String::~String() {
+  v8_string_.Reset();
+}
+
+string_view String::StringView() {
+  string_view view = { val_.data(), val_.size() };
+
+  if (!Handle<ExternalBuffer>::Is(NULL, external_)) {
+    view.data = external_->Data();
+    view.length = external_->Length();
+    return view;
+  }
+
+  if (v8_string_.IsEmpty()) {
+    return view;
+  }
+
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::HandleScope handle_scope(isolate);
+  v8::Local<v8::String> v8_string =
+    v8_string_.Get(isolate);
+
+  if (v8_string->IsExternalAscii()) {
+    const v8::String::ExternalAsciiStringResource* resource =
+      v8_string->GetExternalAsciiStringResource();
+
+    view.data = resource->data();
+    view.length = resource->length();
+    return view;
+  }
+
+  int length = v8_string->Utf8Length();
+
+  if (string_view_buffer.size() < static_cast<size_t>(length) + 1) {
+    string_view_buffer.resize(length + 1);
+  }
+
+  v8_string->WriteUtf8(
+    &string_view_buffer[0], length, NULL, v8::String::NO_NULL_TERMINATION);
+  view.data = &string_view_buffer[0];
+  view.length = length;
+
+  return view;
+}
+
+// Keeps the buffer alive for as long as the V8 string, V8 disposes the
+// resource when the string is collected or the isolate torn down.
+class ExternalBufferResource
+    : public v8::String::ExternalAsciiStringResource {
+ public:
+  explicit ExternalBufferResource(Handle<ExternalBuffer> buffer)
+    : buffer_(buffer) {}
+
+  const char* data() const {
+    return buffer_->Data();
+  }
+
+  size_t length() const {
+    return buffer_->Length();
+  }
+
+ private:
+  Handle<ExternalBuffer> buffer_;
+};
+
+v8::Local<v8::Value> String::Extract() {
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+
+  if (!v8_string_.IsEmpty()) {
+    return v8_string_.Get(isolate);
+  }
+
+  if (!Handle<ExternalBuffer>::Is(NULL, external_)) {
+    if (external_->IsAscii()) {
+      return v8::String::NewExternal(
+        isolate, new ExternalBufferResource(external_));
+    }
+
+    return v8::String::NewFromUtf8(
+      isolate,
+      external_->Data(),
+      v8::String::kNormalString,
+      static_cast<int>(external_->Length()));
+  }
+
+  return v8::String::NewFromUtf8(
+    isolate, val_.data(), v8::String::kNormalString, val_.size());
+}
+
+#endif
+
+//
+// JavascriptCore Value
+//
+
+
+#ifdef BASTIAN_JSC
+
+static JSGlobalContextRef RetainJSCContext(JSContextRef context_ref) {
+  return JSGlobalContextRetain(JSContextGetGlobalContext(context_ref));
+}
+
+Handle<Value> Value::New(JSValueRef jsc_value) {
+  return New(RunContext::CurrentJSCContext(), jsc_value);
+}
+
+Handle<Value> Value::New(JSContextRef context_ref, JSValueRef jsc_value) {
+  Handle<Value> result = NullValue::New();
+  JSStringRef jsc_string;
+  JSObjectRef jsc_object;
+  JSValueRef* exception_ref = 0;
+
+  // Left by an operation which threw.
+  if (jsc_value == NULL) {
+    return UndefinedValue::New();
+  }
+
+  if (JSValueIsNumber(context_ref, jsc_value)) {
+    result = Number::New(JSValueToNumber(
+      context_ref,
+      jsc_value,
+      exception_ref));
+  } else if (JSValueIsBoolean(context_ref, jsc_value)) {
+    result = Boolean::New(JSValueToBoolean(context_ref, jsc_value));
+  } else if (JSValueIsUndefined(context_ref, jsc_value)) {
+    result = UndefinedValue::New();
+  } else if (JSValueIsString(context_ref, jsc_value)) {
+    jsc_string = JSValueToStringCopy(
+      context_ref,
+      jsc_value,
+      exception_ref);
+
+    std::string val(JSStringGetMaximumUTF8CStringSize(jsc_string), '\0');
+    val.resize(JSStringGetUTF8CString(jsc_string, &val[0], val.size()) - 1);
+    JSStringRelease(jsc_string);
+    result = String::New(val);
+  } else if (JSValueIsObject(context_ref, jsc_value)) {
+    jsc_object = JSValueToObject(context_ref, jsc_value, NULL);
+    JSTypedArrayType array_type =
+      JSValueGetTypedArrayType(context_ref, jsc_value, NULL);
+
+    if (array_type == kJSTypedArrayTypeArrayBuffer) {
+      result = ArrayBuffer::New(context_ref, jsc_object);
+    } else if (array_type != kJSTypedArrayTypeNone) {
+      result = TypedArray::New(context_ref, jsc_object);
+    } else if (JSValueIsArray(context_ref, jsc_value)) {
+      result = Array::New(context_ref, jsc_object);
+    } else if (JSObjectIsFunction(context_ref, jsc_object)) {
+      result = Function::New(context_ref, jsc_object);
+    } else {
+      result = Object::New(context_ref, jsc_object);
+    }
+  }
+
+  return result;
+}
+
+JSValueRef Value::Extract() {
+  JSValueRef result;
+  JSContextRef context_ref = RunContext::GetCurrent()->jsc_context_;
+
+
+  if (IsNumber()) {
+    result = JSValueMakeNumber(context_ref, NumberValue());
+  } else if (IsString()) {
+    result = JSValueMakeString(
+      context_ref,
+      JSStringCreateWithUTF8CString(StringValue().c_str()));
+  } else if (IsBoolean()) {
+    result = JSValueMakeBoolean(context_ref, BooleanValue());
+  } else if (IsUndefined()) {
+    result = JSValueMakeUndefined(context_ref);
+  } else {
+    result = JSValueMakeNull(context_ref);
+  }
+
+  return result;
+}
+
+#endif
+
+
+//
+// JSC String
+//
+
+
+#ifdef BASTIAN_JSC
+
+// Strings from scripts are copied when converted, the characters are
+// always in host memory.
+string_view String::StringView() {
+  string_view view = { val_.data(), val_.size() };
+
+  if (!Handle<ExternalBuffer>::Is(NULL, external_)) {
+    view.data = external_->Data();
+    view.length = external_->Length();
+  }
+
+  return view;
+}
+
+// The C API has no external strings, the characters are copied.
+JSValueRef String::Extract() {
+  JSContextRef context_ref = RunContext::CurrentJSCContext();
+  JSStringRef jsc_string = JSStringCreateWithUTF8CString(
+    StringValue().c_str());
+  JSValueRef result = JSValueMakeString(context_ref, jsc_string);
+
+  JSStringRelease(jsc_string);
+
+  return result;
+}
+
+#endif
+
+
+//
+// V8 Array
+//
+
+
+#ifdef BASTIAN_V8
+
+Array::~Array() {
+  v8_array_.Reset();
+}
+
+Handle<Value> Array::New(const v8::Local<v8::Array>& v8_array) {
+  Array* array = new Array(std::vector<Handle<Value>>());
+
+  array->v8_array_.Reset(v8::Isolate::GetCurrent(), v8_array);
+
+  Handle<Value> value(reinterpret_cast<Value*>(array));
+  return value;
+}
+
+size_t Array::Length() {
+  if (v8_array_.IsEmpty()) {
+    return elements_.size();
+  }
+
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::HandleScope handle_scope(isolate);
+
+  return v8_array_.Get(isolate)->Length();
+}
+
+Handle<Value> Array::Get(size_t index) {
+  if (index >= Length()) {
+    return UndefinedValue::New();
+  }
+
+  if (v8_array_.IsEmpty()) {
+    return elements_.at(index);
+  }
+
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::HandleScope handle_scope(isolate);
+  v8::Local<v8::Array> v8_array = v8_array_.Get(isolate);
+  v8::Context::Scope context_scope(v8_array->CreationContext());
+  v8::TryCatch try_catch;
+
+  return Value::New(v8_array->Get(static_cast<uint32_t>(index)));
+}
+
+// Script arrays are read element by element, V8 has no bulk access to
+// the elements of an array.
+bool Array::ToVector(std::vector<double>* values) {
+  if (v8_array_.IsEmpty()) {
+    values->resize(elements_.size());
+
+    for (size_t index = 0; index < elements_.size(); ++index) {
+      (*values)[index] = ElementNumber(elements_[index]);
+    }
+
+    return true;
+  }
+
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::HandleScope handle_scope(isolate);
+  v8::Local<v8::Array> v8_array = v8_array_.Get(isolate);
+  v8::Context::Scope context_scope(v8_array->CreationContext());
+  v8::TryCatch try_catch;
+  uint32_t length = v8_array->Length();
+
+  values->resize(length);
+
+  for (uint32_t index = 0; index < length; ++index) {
+    v8::HandleScope element_scope(isolate);
+    v8::Local<v8::Value> element = v8_array->Get(index);
+
+    try_catch.Reset();
+    (*values)[index] = !element.IsEmpty() && element->IsNumber() ?
+      element.As<v8::Number>()->Value() :
+      std::numeric_limits<double>::quiet_NaN();
+  }
+
+  return true;
+}
+
+v8::Local<v8::Value> Array::Extract() {
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+
+  if (!v8_array_.IsEmpty()) {
+    return v8_array_.Get(isolate);
+  }
+
+  v8::Local<v8::Array> v8_array =
+    v8::Array::New(isolate, static_cast<int>(elements_.size()));
+
+  for (size_t index = 0; index < elements_.size(); ++index) {
+    v8_array->Set(static_cast<uint32_t>(index), elements_[index]->Extract());
+  }
+
+  return v8_array;
+}
+
+#endif
+
+//
+// JSC Array
+//
+
+
+#ifdef BASTIAN_JSC
+
+Array::~Array() {
+  if (jsc_object_ != NULL) {
+    JSValueUnprotect(jsc_context_, jsc_object_);
+    JSGlobalContextRelease(jsc_context_);
+  }
+}
+
+Handle<Value> Array::New(JSContextRef context_ref, JSObjectRef jsc_object) {
+  Array* array = new Array(std::vector<Handle<Value>>());
+
+  array->jsc_object_ = jsc_object;
+  array->jsc_context_ = RetainJSCContext(context_ref);
+  JSValueProtect(context_ref, jsc_object);
+
+  Handle<Value> value(reinterpret_cast<Value*>(array));
+  return value;
+}
+
+size_t Array::Length() {
+  if (jsc_object_ == NULL) {
+    return elements_.size();
+  }
+
+  JSStringRef name = JSStringCreateWithUTF8CString("length");
+  JSValueRef length = JSObjectGetProperty(
+    jsc_context_, jsc_object_, name, NULL);
+
+  JSStringRelease(name);
+
+  return static_cast<size_t>(JSValueToNumber(jsc_context_, length, NULL));
+}
+
+Handle<Value> Array::Get(size_t index) {
+  if (index >= Length()) {
+    return UndefinedValue::New();
+  }
+
+  if (jsc_object_ == NULL) {
+    return elements_.at(index);
+  }
+
+  JSValueRef exception = NULL;
+  JSValueRef element = JSObjectGetPropertyAtIndex(
+    jsc_context_,
+    jsc_object_,
+    static_cast<unsigned>(index),
+    &exception);
+
+  if (exception != NULL) {
+    return UndefinedValue::New();
+  }
+
+  return Value::New(jsc_context_, element);
+}
+
+bool Array::ToVector(std::vector<double>* values) {
+  size_t length = Length();
+
+  values->resize(length);
+
+  if (jsc_object_ == NULL) {
+    for (size_t index = 0; index < length; ++index) {
+      (*values)[index] = ElementNumber(elements_[index]);
+    }
+
+    return true;
+  }
+
+  JSContextRef context_ref = jsc_context_;
+
+  for (size_t index = 0; index < length; ++index) {
+    JSValueRef exception = NULL;
+    JSValueRef element = JSObjectGetPropertyAtIndex(
+      context_ref, jsc_object_, static_cast<unsigned>(index), &exception);
+
+    (*values)[index] = exception == NULL &&
+        JSValueIsNumber(context_ref, element) ?
+      JSValueToNumber(context_ref, element, NULL) :
+      std::numeric_limits<double>::quiet_NaN();
+  }
+
+  return true;
+}
+
+JSValueRef Array::Extract() {
+  if (jsc_object_ != NULL) {
+    return static_cast<JSValueRef>(jsc_object_);
+  }
+
+  std::vector<JSValueRef> elements(elements_.size());
+
+  for (size_t index = 0; index < elements_.size(); ++index) {
+    elements[index] = elements_[index]->Extract();
+  }
+
+  return JSObjectMakeArray(
+    RunContext::CurrentJSCContext(),
+    elements.size(),
+    elements.empty() ? NULL : &elements[0],
+    NULL);
+}
+
+#endif
+
+//
+// V8 ArrayBuffer
+//
+
+
+#ifdef BASTIAN_V8
+
+// Array buffers seen by bastian are external, their memory is owned by an
+// ExternalBuffer which the first internal field points to. The object
+// keeps a reference to the buffer until it is collected.
+static const int kExternalBufferField = 0;
+
+struct ArrayBufferKeeper {
+  v8::Persistent<v8::ArrayBuffer> v8_buffer;
+  Handle<ExternalBuffer> buffer;
+};
+
+static void ReleaseArrayBuffer(
+    const v8::WeakCallbackData<v8::ArrayBuffer, ArrayBufferKeeper>& data) {
+  ArrayBufferKeeper* keeper = data.GetParameter();
+
+  keeper->v8_buffer.Reset();
+  delete keeper;
+}
+
+static void KeepBuffer(
+    v8::Isolate* isolate,
+    v8::Local<v8::ArrayBuffer> v8_buffer,
+    Handle<ExternalBuffer> buffer) {
+  ArrayBufferKeeper* keeper = new ArrayBufferKeeper();
+
+  keeper->buffer = buffer;
+  keeper->v8_buffer.Reset(isolate, v8_buffer);
+  keeper->v8_buffer.SetWeak(keeper, ReleaseArrayBuffer);
+  v8_buffer->SetAlignedPointerInInternalField(
+    kExternalBufferField, buffer.operator->());
+}
+
+// Buffers allocated by scripts are externalized, bastian::Init installs
+// a malloc based allocator so that their memory is freed with free(). An
+// empty handle is returned for buffers externalized by other code, whose
+// memory can not be reached, and when V8 was set up without bastian::Init,
+// the memory then comes from an allocator free() does not know.
+static Handle<ExternalBuffer> SharedBuffer(
+    v8::Isolate* isolate,
+    v8::Local<v8::ArrayBuffer> v8_buffer) {
+  if (v8_buffer->IsExternal()) {
+    Handle<ExternalBuffer> buffer(static_cast<ExternalBuffer*>(
+      v8_buffer->GetAlignedPointerFromInternalField(kExternalBufferField)));
+    return buffer;
+  }
+
+  if (!OwnsArrayBufferAllocator()) {
+    return Handle<ExternalBuffer>();
+  }
+
+  v8::ArrayBuffer::Contents contents = v8_buffer->Externalize();
+  Handle<ExternalBuffer> buffer = ExternalBuffer::New(
+    contents.Data(), contents.ByteLength(), FreeBytes, contents.Data());
+
+  KeepBuffer(isolate, v8_buffer, buffer);
+
+  return buffer;
+}
+
+static v8::Local<v8::ArrayBuffer> NewV8ArrayBuffer(
+    v8::Isolate* isolate,
+    Handle<ExternalBuffer> buffer) {
+  v8::Local<v8::ArrayBuffer> v8_buffer =
+    v8::ArrayBuffer::New(isolate, buffer->Bytes(), buffer->Length());
+
+  KeepBuffer(isolate, v8_buffer, buffer);
+
+  return v8_buffer;
+}
+
+ArrayBuffer::ArrayBuffer(Handle<ExternalBuffer> buffer) : buffer_(buffer) {
+  type_ = ARRAY_BUFFER;
+}
+
+ArrayBuffer::~ArrayBuffer() {
+  v8_buffer_.Reset();
+}
+
+Handle<Value> ArrayBuffer::New(const v8::Local<v8::ArrayBuffer>& v8_buffer) {
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  Handle<ExternalBuffer> buffer = SharedBuffer(isolate, v8_buffer);
+
+  if (Handle<ExternalBuffer>::Is(NULL, buffer)) {
+    return NullValue::New();
+  }
+
+  ArrayBuffer* array_buffer = new ArrayBuffer(buffer);
+
+  array_buffer->v8_buffer_.Reset(isolate, v8_buffer);
+
+  Handle<Value> value(reinterpret_cast<Value*>(array_buffer));
+  return value;
+}
+
+// Buffers made by the host get a new V8 object on each extraction, so
+// that a value can be handed to several isolates.
+v8::Local<v8::Value> ArrayBuffer::Extract() {
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+
+  if (!v8_buffer_.IsEmpty()) {
+    return v8_buffer_.Get(isolate);
+  }
+
+  return NewV8ArrayBuffer(isolate, buffer_);
+}
+
+#endif
+
+//
+// V8 TypedArray
+//
+
+
+#ifdef BASTIAN_V8
+
+TypedArray::~TypedArray() {
+  v8_array_.Reset();
+}
+
+Handle<Value> TypedArray::New(const v8::Local<v8::TypedArray>& v8_array) {
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  Type type;
+
+  if (v8_array->IsFloat64Array()) {
+    type = FLOAT64_ARRAY;
+  } else if (v8_array->IsInt32Array()) {
+    type = INT32_ARRAY;
+  } else if (v8_array->IsUint8Array()) {
+    type = UINT8_ARRAY;
+  } else {
+    return NullValue::New();
+  }
+
+  Handle<ExternalBuffer> buffer = SharedBuffer(isolate, v8_array->Buffer());
+
+  if (Handle<ExternalBuffer>::Is(NULL, buffer)) {
+    return NullValue::New();
+  }
+
+  Handle<Value> value = New(
+    type, buffer, v8_array->ByteOffset(), v8_array->Length());
+
+  if (value->IsTypedArray()) {
+    static_cast<TypedArray*>(value.operator->())->v8_array_.Reset(
+      isolate, v8_array);
+  }
+
+  return value;
+}
+
+v8::Local<v8::Value> TypedArray::Extract() {
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+
+  if (!v8_array_.IsEmpty()) {
+    return v8_array_.Get(isolate);
+  }
+
+  v8::Local<v8::ArrayBuffer> v8_buffer = NewV8ArrayBuffer(isolate, buffer_);
+
+  switch (type_) {
+    case FLOAT64_ARRAY:
+      return v8::Float64Array::New(v8_buffer, byte_offset_, length_);
+    case INT32_ARRAY:
+      return v8::Int32Array::New(v8_buffer, byte_offset_, length_);
+    default:
+      return v8::Uint8Array::New(v8_buffer, byte_offset_, length_);
+  }
+}
+
+#endif
+
+//
+// JSC ArrayBuffer
+//
+
+
+#ifdef BASTIAN_JSC
+
+// Keeps the script object owning the memory of a buffer alive.
+struct ProtectedBytes {
+  JSGlobalContextRef context;
+  JSObjectRef object;
+};
+
+static void UnprotectBytes(void* user_data) {
+  ProtectedBytes* bytes = static_cast<ProtectedBytes*>(user_data);
+
+  JSValueUnprotect(bytes->context, bytes->object);
+  JSGlobalContextRelease(bytes->context);
+  delete bytes;
+}
+
+static Handle<ExternalBuffer> SharedBuffer(
+    JSGlobalContextRef context_ref,
+    JSObjectRef jsc_buffer) {
+  ProtectedBytes* bytes = new ProtectedBytes();
+
+  bytes->context = JSGlobalContextRetain(context_ref);
+  bytes->object = jsc_buffer;
+  JSValueProtect(context_ref, jsc_buffer);
+
+  return ExternalBuffer::New(
+    JSObjectGetArrayBufferBytesPtr(context_ref, jsc_buffer, NULL),
+    JSObjectGetArrayBufferByteLength(context_ref, jsc_buffer, NULL),
+    UnprotectBytes,
+    bytes);
+}
+
+static void DeallocateBytes(void* bytes, void* deallocator_context) {
+  delete static_cast<Handle<ExternalBuffer>*>(deallocator_context);
+}
+
+static JSObjectRef NewJSCArrayBuffer(
+    JSContextRef context_ref,
+    Handle<ExternalBuffer> buffer) {
+  return JSObjectMakeArrayBufferWithBytesNoCopy(
+    context_ref,
+    buffer->Bytes(),
+    buffer->Length(),
+    DeallocateBytes,
+    new Handle<ExternalBuffer>(buffer),
+    NULL);
+}
+
+ArrayBuffer::ArrayBuffer(Handle<ExternalBuffer> buffer)
+  : jsc_object_(NULL),
+    jsc_context_(NULL),
+    buffer_(buffer) {
+  type_ = ARRAY_BUFFER;
+}
+
+ArrayBuffer::~ArrayBuffer() {
+  if (jsc_object_ != NULL) {
+    JSValueUnprotect(jsc_context_, jsc_object_);
+    JSGlobalContextRelease(jsc_context_);
+  }
+}
+
+Handle<Value> ArrayBuffer::New(
+    JSContextRef context_ref,
+    JSObjectRef jsc_object) {
+  ArrayBuffer* array_buffer = new ArrayBuffer(
+    SharedBuffer(JSContextGetGlobalContext(context_ref), jsc_object));
+
+  array_buffer->jsc_object_ = jsc_object;
+  array_buffer->jsc_context_ = RetainJSCContext(context_ref);
+  JSValueProtect(context_ref, jsc_object);
+
+  Handle<Value> value(reinterpret_cast<Value*>(array_buffer));
+  return value;
+}
+
+JSValueRef ArrayBuffer::Extract() {
+  if (jsc_object_ != NULL) {
+    return static_cast<JSValueRef>(jsc_object_);
+  }
+
+  return NewJSCArrayBuffer(RunContext::CurrentJSCContext(), buffer_);
+}
+
+#endif
+
+//
+// JSC TypedArray
+//
+
+
+#ifdef BASTIAN_JSC
+
+TypedArray::~TypedArray() {
+  if (jsc_object_ != NULL) {
+    JSValueUnprotect(jsc_context_, jsc_object_);
+    JSGlobalContextRelease(jsc_context_);
+  }
+}
+
+Handle<Value> TypedArray::New(
+    JSContextRef context_ref,
+    JSObjectRef jsc_object) {
+  Type type;
+
+  switch (JSValueGetTypedArrayType(context_ref, jsc_object, NULL)) {
+    case kJSTypedArrayTypeFloat64Array:
+      type = FLOAT64_ARRAY;
+      break;
+    case kJSTypedArrayTypeInt32Array:
+      type = INT32_ARRAY;
+      break;
+    case kJSTypedArrayTypeUint8Array:
+      type = UINT8_ARRAY;
+      break;
+    default:
+      return NullValue::New();
+  }
+
+  Handle<ExternalBuffer> buffer = SharedBuffer(
+    JSContextGetGlobalContext(context_ref),
+    JSObjectGetTypedArrayBuffer(context_ref, jsc_object, NULL));
+  Handle<Value> value = New(
+    type,
+    buffer,
+    JSObjectGetTypedArrayByteOffset(context_ref, jsc_object, NULL),
+    JSObjectGetTypedArrayLength(context_ref, jsc_object, NULL));
+
+  if (value->IsTypedArray()) {
+    TypedArray* array = static_cast<TypedArray*>(value.operator->());
+
+    array->jsc_object_ = jsc_object;
+    array->jsc_context_ = RetainJSCContext(context_ref);
+    JSValueProtect(context_ref, jsc_object);
+  }
+
+  return value;
+}
+
+JSValueRef TypedArray::Extract() {
+  JSContextRef context_ref = RunContext::CurrentJSCContext();
+  JSTypedArrayType array_type;
+
+  if (jsc_object_ != NULL) {
+    return static_cast<JSValueRef>(jsc_object_);
+  }
+
+  switch (type_) {
+    case FLOAT64_ARRAY:
+      array_type = kJSTypedArrayTypeFloat64Array;
+      break;
+    case INT32_ARRAY:
+      array_type = kJSTypedArrayTypeInt32Array;
+      break;
+    default:
+      array_type = kJSTypedArrayTypeUint8Array;
+      break;
+  }
+
+  return JSObjectMakeTypedArrayWithArrayBufferAndOffset(
+    context_ref,
+    array_type,
+    NewJSCArrayBuffer(context_ref, buffer_),
+    byte_offset_,
+    length_,
+    NULL);
+}
+
+#endif
+
+//
+// Common Function
+//
+
+
+Handle<Value> Function::Call(const std::vector<Handle<Value>>& arguments) {
+  Handle<Value> function(this);
+  CallSite site(function);
+
+  return site.Invoke(arguments);
+}
+
+std::vector<Handle<Value>> Function::CallBatch(
+    const std::vector<std::vector<Handle<Value>>>& calls) {
+  Handle<Value> function(this);
+  CallSite site(function);
+  std::vector<Handle<Value>> results;
+
+  site.InvokeBatch(calls, &results);
+
+  return results;
+}
+
+
+//
+// V8 Function
+//
+
+#ifdef BASTIAN_V8
+
+Function::Function(const v8::Local<v8::Function>& v8_function) {
+  v8_function_.Reset(v8::Isolate::GetCurrent(), v8_function);
+  type_ = FUNCTION;
+}
+
+Function::~Function() {
+  v8_function_.Reset();
+}
+
+Handle<Value> Function::New(const v8::Local<v8::Function>& v8_function) {
+  Handle<Value> function(reinterpret_cast<Value*>(new Function (v8_function)));
+  return function;
+}
+
+v8::Local<v8::Value> Function::Extract() {
+  return v8_function_.Get(v8::Isolate::GetCurrent());
+}
+
+#endif
+
+//
+// JSC Function
+//
+
+#ifdef BASTIAN_JSC
+
+Function::Function(JSContextRef context_ref, JSObjectRef jsc_object)
+  : jsc_object_(jsc_object),
+    jsc_context_(RetainJSCContext(context_ref)) {
+  type_ = FUNCTION;
+  JSValueProtect(jsc_context_, jsc_object_);
+}
+
+Function::~Function() {
+  JSValueUnprotect(jsc_context_, jsc_object_);
+  JSGlobalContextRelease(jsc_context_);
+}
+
+Handle<Value> Function::New(JSContextRef context_ref, JSObjectRef jsc_object) {
+  Handle<Value> function(reinterpret_cast<Value*>(
+    new Function(context_ref, jsc_object)));
+  return function;
+}
+
+JSValueRef Function::Extract() {
+  return static_cast<JSValueRef>(jsc_object_);
+}
+
+#endif
+
+
+//
+// Common Object
+//
+
+
+Object::Object() : keys_read_(false) {
+  type_ = OBJECT;
+#ifdef BASTIAN_JSC
+  jsc_object_ = NULL;
+  jsc_context_ = NULL;
+#endif
+}
+
+Handle<Value> Object::New(
+    const std::vector<std::pair<std::string, Handle<Value>>>& properties) {
+  Object* object = new Object();
+
+  for (size_t index = 0; index < properties.size(); ++index) {
+    std::pair<std::map<std::string, Handle<Value>>::iterator, bool> inserted =
+      object->properties_.insert(properties[index]);
+
+    if (inserted.second) {
+      object->keys_.push_back(properties[index].first);
+    } else {
+      inserted.first->second = properties[index].second;
+    }
+  }
+
+  object->keys_read_ = true;
+
+  Handle<Value> value(reinterpret_cast<Value*>(object));
+  return value;
+}
+
+Object* Object::Cast(const Handle<Value>& value) {
+  if (!value->IsObject()) {
+    return NULL;
+  }
+
+  return static_cast<Object*>(value.operator->());
+}
+
+
+//
+// V8 Object
+//
+
+#ifdef BASTIAN_V8
+
+Handle<Value> Object::New(void (*obj_generator)(Handle<V8ObjectContext>)) {
+  Handle<Value> value(reinterpret_cast<Value*>(new Object(obj_generator)));
+  return value;
+}
+
+Object::Object(void (*obj_generator)(Handle<V8ObjectContext>)) : Object() {
+  Handle<V8ObjectContext> object_context = V8ObjectContext::New();
+  obj_generator(object_context);
+  v8::Local<v8::Object> local_instance = object_context->ObjectTemplate()->NewInstance();
+  v8_object_.Reset(v8::Isolate::GetCurrent(), local_instance);
+}
+
+Object::~Object() {
+  v8_object_.Reset();
+}
+
+Handle<Value> Object::New(const v8::Local<v8::Object>& v8_object) {
+  Object* object = new Object();
+
+  object->v8_object_.Reset(v8::Isolate::GetCurrent(), v8_object);
+
+  Handle<Value> value(reinterpret_cast<Value*>(object));
+  return value;
+}
+
+v8::Local<v8::Value> Object::Extract() {
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+
+  if (v8_object_.IsEmpty()) {
+    v8::Local<v8::Object> v8_object = v8::Object::New(isolate);
+
+    for (size_t index = 0; index < keys_.size(); ++index) {
+      const std::string& key = keys_[index];
+
+      v8_object->Set(
+        v8::String::NewFromUtf8(
+          isolate, key.data(), v8::String::kNormalString, key.size()),
+        properties_[key]->Extract());
+    }
+
+    return v8_object;
+  }
+
+  v8::Local<v8::Object> local_instance = v8_object_.Get(isolate);
+  return local_instance;
+}
+
+Handle<Value> Object::Get(const std::string& key) {
+  bool threw;
+
+  return Get(key, &threw);
+}
+
+Handle<Value> Object::Get(const std::string& key, bool* threw) {
+  std::map<std::string, Handle<Value>>::iterator cached = properties_.find(key);
+
+  *threw = false;
+
+  if (cached != properties_.end()) {
+    return cached->second;
+  }
+
+  if (v8_object_.IsEmpty()) {
+    return UndefinedValue::New();
+  }
+
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::HandleScope handle_scope(isolate);
+  v8::Local<v8::Object> v8_object = v8_object_.Get(isolate);
+  v8::Context::Scope context_scope(v8_object->CreationContext());
+  v8::TryCatch try_catch;
+  Handle<Value> value = Value::New(v8_object->Get(v8::String::NewFromUtf8(
+    isolate, key.data(), v8::String::kNormalString, key.size())));
+
+  // A read which threw is tried again next time.
+  *threw = try_catch.HasCaught();
+
+  if (!*threw) {
+    properties_.insert(std::make_pair(key, value));
+  }
+
+  return value;
+}
+
+Handle<Value> Object::JSONValue(const std::string& key, bool* threw) {
+  *threw = false;
+
+  if (v8_object_.IsEmpty()) {
+    return Handle<Value>();
+  }
+
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::HandleScope handle_scope(isolate);
+  v8::Local<v8::Object> v8_object = v8_object_.Get(isolate);
+  v8::Context::Scope context_scope(v8_object->CreationContext());
+  v8::TryCatch try_catch;
+  v8::Local<v8::Value> to_json =
+    v8_object->Get(v8::String::NewFromUtf8(isolate, "toJSON"));
+
+  if (!to_json.IsEmpty() && to_json->IsFunction()) {
+    v8::Local<v8::Value> argument = v8::String::NewFromUtf8(
+      isolate, key.data(), v8::String::kNormalString, key.size());
+
+    v8::Local<v8::Value> result =
+      to_json.As<v8::Function>()->Call(v8_object, 1, &argument);
+
+    *threw = try_catch.HasCaught();
+
+    return Value::New(result);
+  }
+
+  if (try_catch.HasCaught()) {
+    *threw = true;
+    return UndefinedValue::New();
+  }
+
+  if (v8_object->IsNumberObject()) {
+    return Number::New(v8_object.As<v8::NumberObject>()->ValueOf());
+  }
+
+  if (v8_object->IsStringObject()) {
+    return Value::New(v8_object.As<v8::StringObject>()->ValueOf());
+  }
+
+  if (v8_object->IsBooleanObject()) {
+    return Boolean::New(v8_object.As<v8::BooleanObject>()->ValueOf());
+  }
+
+  return Handle<Value>();
+}
+
+const std::vector<std::string>& Object::Keys() {
+  if (keys_read_) {
+    return keys_;
+  }
+
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::HandleScope handle_scope(isolate);
+  v8::Local<v8::Object> v8_object = v8_object_.Get(isolate);
+  v8::Context::Scope context_scope(v8_object->CreationContext());
+  v8::TryCatch try_catch;
+  v8::Local<v8::Array> names = v8_object->GetOwnPropertyNames();
+
+  keys_read_ = true;
+
+  if (names.IsEmpty()) {
+    return keys_;
+  }
+
+  keys_.reserve(names->Length());
+
+  for (uint32_t index = 0; index < names->Length(); ++index) {
+    v8::String::Utf8Value name(names->Get(index));
+    keys_.push_back(std::string(*name, name.length()));
+  }
+
+  return keys_;
+}
+
+
+#endif
+
+
+//
+// JSC Object
+//
+
+
+#ifdef BASTIAN_JSC
+
+Handle<Value> Object::New(void (*jsc_obj_generator)(Handle<JSCObjectContext>)) {
+  Handle<Value> value(reinterpret_cast<Value*>(new Object(jsc_obj_generator)));
+  return value;
+}
+
+Object::Object(void (*jsc_obj_generator)(Handle<JSCObjectContext>))
+  : Object() {
+  Handle<JSCObjectContext> object_context = JSCObjectContext::New();
+  jsc_obj_generator(object_context);
+  object_context->Build("Native Object");
+  jsc_object_ = object_context->object_ref_;
+  jsc_context_ = RetainJSCContext(RunContext::CurrentJSCContext());
+  JSValueProtect(jsc_context_, jsc_object_);
+}
+
+Object::~Object() {
+  if (jsc_object_ != NULL) {
+    JSValueUnprotect(jsc_context_, jsc_object_);
+    JSGlobalContextRelease(jsc_context_);
+  }
+}
+
+Handle<Value> Object::New(JSContextRef context_ref, JSObjectRef jsc_object) {
+  Object* object = new Object();
+
+  object->jsc_object_ = jsc_object;
+  object->jsc_context_ = RetainJSCContext(context_ref);
+  JSValueProtect(context_ref, jsc_object);
+
+  Handle<Value> value(reinterpret_cast<Value*>(object));
+  return value;
+}
+
+JSValueRef Object::Extract() {
+  if (jsc_object_ == NULL) {
+    JSContextRef context_ref = RunContext::CurrentJSCContext();
+    JSObjectRef jsc_object = JSObjectMake(context_ref, NULL, NULL);
+
+    for (size_t index = 0; index < keys_.size(); ++index) {
+      JSStringRef name = JSStringCreateWithUTF8CString(keys_[index].c_str());
+
+      JSObjectSetProperty(
+        context_ref,
+        jsc_object,
+        name,
+        properties_[keys_[index]]->Extract(),
+        kJSPropertyAttributeNone,
+        NULL);
+      JSStringRelease(name);
+    }
+
+    return static_cast<JSValueRef>(jsc_object);
+  }
+
+  return static_cast<JSValueRef>(jsc_object_);
+}
+
+Handle<Value> Object::Get(const std::string& key) {
+  bool threw;
+
+  return Get(key, &threw);
+}
+
+Handle<Value> Object::Get(const std::string& key, bool* threw) {
+  std::map<std::string, Handle<Value>>::iterator cached = properties_.find(key);
+
+  *threw = false;
+
+  if (cached != properties_.end()) {
+    return cached->second;
+  }
+
+  if (jsc_object_ == NULL) {
+    return UndefinedValue::New();
+  }
+
+  JSValueRef exception = NULL;
+  JSStringRef name = JSStringCreateWithUTF8CString(key.c_str());
+  JSValueRef property = JSObjectGetProperty(
+    jsc_context_, jsc_object_, name, &exception);
+
+  JSStringRelease(name);
+
+  if (exception != NULL) {
+    *threw = true;
+    return UndefinedValue::New();
+  }
+
+  Handle<Value> value = Value::New(jsc_context_, property);
+
+  properties_.insert(std::make_pair(key, value));
+
+  return value;
+}
+
+static JSValueRef GetJSCProperty(
+    JSContextRef context_ref,
+    JSObjectRef object,
+    const char * key,
+    JSValueRef* exception) {
+  JSStringRef name = JSStringCreateWithUTF8CString(key);
+  JSValueRef property = JSObjectGetProperty(
+    context_ref, object, name, exception);
+
+  JSStringRelease(name);
+
+  return property;
+}
+
+// JSC has no test for primitive wrappers, they are told apart by their
+// constructor.
+static bool IsJSCWrapper(JSContextRef context_ref, JSObjectRef object) {
+  static const char * const constructors[] = { "Number", "String", "Boolean" };
+  JSObjectRef global = JSContextGetGlobalObject(context_ref);
+
+  for (size_t index = 0; index < 3; ++index) {
+    JSValueRef constructor = GetJSCProperty(
+      context_ref, global, constructors[index], NULL);
+
+    if (JSValueIsObject(context_ref, constructor) &&
+        JSValueIsInstanceOfConstructor(
+          context_ref,
+          object,
+          JSValueToObject(context_ref, constructor, NULL),
+          NULL)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+Handle<Value> Object::JSONValue(const std::string& key, bool* threw) {
+  *threw = false;
+
+  if (jsc_object_ == NULL) {
+    return Handle<Value>();
+  }
+
+  JSContextRef context_ref = jsc_context_;
+  JSValueRef exception = NULL;
+  JSValueRef to_json = GetJSCProperty(
+    context_ref, jsc_object_, "toJSON", &exception);
+  JSValueRef argument = NULL;
+  size_t argument_count = 0;
+
+  if (exception != NULL) {
+    *threw = true;
+    return UndefinedValue::New();
+  }
+
+  JSObjectRef method = JSValueIsObject(context_ref, to_json) ?
+    JSValueToObject(context_ref, to_json, NULL) :
+    NULL;
+
+  if (method != NULL && JSObjectIsFunction(context_ref, method)) {
+    JSStringRef key_string = JSStringCreateWithUTF8CString(key.c_str());
+
+    argument = JSValueMakeString(context_ref, key_string);
+    argument_count = 1;
+    JSStringRelease(key_string);
+  } else if (IsJSCWrapper(context_ref, jsc_object_)) {
+    JSValueRef value_of = GetJSCProperty(
+      context_ref, jsc_object_, "valueOf", &exception);
+
+    method = exception == NULL && JSValueIsObject(context_ref, value_of) ?
+      JSValueToObject(context_ref, value_of, NULL) :
+      NULL;
+  } else {
+    return Handle<Value>();
+  }
+
+  JSValueRef result = NULL;
+
+  if (method != NULL) {
+    result = JSObjectCallAsFunction(
+      context_ref,
+      method,
+      jsc_object_,
+      argument_count,
+      argument_count == 0 ? NULL : &argument,
+      &exception);
+  }
+
+  if (result == NULL || exception != NULL) {
+    *threw = exception != NULL;
+    return UndefinedValue::New();
+  }
+
+  return Value::New(context_ref, result);
+}
+
+const std::vector<std::string>& Object::Keys() {
+  if (keys_read_) {
+    return keys_;
+  }
+
+  JSPropertyNameArrayRef names = JSObjectCopyPropertyNames(
+    jsc_context_, jsc_object_);
+  size_t count = JSPropertyNameArrayGetCount(names);
+
+  keys_.reserve(count);
+
+  for (size_t index = 0; index < count; ++index) {
+    JSStringRef name = JSPropertyNameArrayGetNameAtIndex(names, index);
+    std::string key(JSStringGetMaximumUTF8CStringSize(name), '\0');
+
+    key.resize(JSStringGetUTF8CString(name, &key[0], key.size()) - 1);
+    keys_.push_back(key);
+  }
+
+  JSPropertyNameArrayRelease(names);
+  keys_read_ = true;
+
+  return keys_;
 }
 
 #endif
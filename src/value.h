@@ -21,10 +21,16 @@
 #ifndef BASTIAN_VALUE_H_
 #define BASTIAN_VALUE_H_
 
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <new>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "./handle.h"
+#include "./persistent.h"
 
 #ifdef BASTIAN_V8
 #include <v8.h>
@@ -37,29 +43,79 @@
 
 namespace bastian {
 
-class Value {
+class Value;
+
+template<>
+class Handle<Value>;
+
+// Characters of a string value, UTF-8 encoded and not NUL terminated.
+typedef struct t_string_view {
+  const char * data;
+  size_t length;
+} string_view;
+
+class Value : public RefCounted {
+  friend class Handle<Value>;
+
  public:
   enum Type {
+    ARRAY,
+    ARRAY_BUFFER,
+    BOOLEAN,
+    FLOAT64_ARRAY,
     FUNCTION,
+    INT32_ARRAY,
     NUL,
     NUMBER,
     OBJECT,
     STRING,
+    UINT8_ARRAY,
     UNDEFINED
   };
 
+  virtual ~Value() {}
+
+  bool IsArray();
+  bool IsArrayBuffer();
+  bool IsBoolean();
   bool IsFunction();
   bool IsNumber();
   bool IsNull();
+  bool IsObject();
   bool IsString();
+  bool IsTypedArray();
   bool IsUndefined();
+  virtual bool BooleanValue() { return false; }
   virtual double NumberValue() {return -1; };
   virtual std::string StringValue() { return ""; };
-  virtual void Call(const std::vector<Handle<Value>>& arguments) {}
-  virtual void Call() {
-    std::vector<Handle<Value>> arguments;
-    Call(arguments);
-  }
+  virtual string_view StringView();
+  // Returns the result of the call, undefined for values which are not
+  // functions. To call a function many times, use a CallSite.
+  virtual Handle<Value> Call(const std::vector<Handle<Value>>& arguments);
+  Handle<Value> Call();
+
+  // One call per argument list, see CallSite::InvokeBatch.
+  virtual std::vector<Handle<Value>> CallBatch(
+    const std::vector<std::vector<Handle<Value>>>& calls);
+
+  // Copies the numbers once into a Float64Array, whose memory is then
+  // shared with the engine.
+  static Handle<Value> FromVector(const std::vector<double>& values);
+
+  // Replaces the content of values with the elements of an array or a
+  // typed array, elements which are not numbers or whose read throws are
+  // NaN. Returns false for other values.
+  virtual bool ToVector(std::vector<double>* values) { return false; }
+
+  // Parses JSON text into host values, objects keep the order of their
+  // keys. Undefined when the text is not valid JSON.
+  static Handle<Value> FromJSON(const char * data, size_t length);
+
+  // JSON text of the value as JSON.stringify writes it, except that typed
+  // arrays are written as arrays of numbers and that toJSON is only called
+  // on script objects. Empty for undefined, for functions and for values
+  // nested too deeply, as cyclic objects are.
+  std::string ToJSON();
 
 #ifdef BASTIAN_V8
   static Handle<Value> New(const v8::Local<v8::Value>&);
@@ -68,10 +124,18 @@ class Value {
 
 #ifdef BASTIAN_JSC
   static Handle<Value> New(JSValueRef jsc_value);
+
+  // Script objects retain the global context they belong to, they are
+  // read and released in it whichever run is current then.
+  static Handle<Value> New(JSContextRef context_ref, JSValueRef jsc_value);
   virtual JSValueRef Extract();
 #endif
 
  protected:
+  // Builds a copy of a primitive value in the storage of a handle, NULL
+  // for the values which are reference counted.
+  virtual Value* CloneInto(void* storage) { return NULL; }
+
   Type type_;
 };
 
@@ -81,6 +145,27 @@ class NullValue : public Value {
 
  private:
   NullValue();
+  Value* CloneInto(void* storage);
+};
+
+class UndefinedValue : public Value {
+ public:
+  static Handle<Value> New();
+
+ private:
+  UndefinedValue();
+  Value* CloneInto(void* storage);
+};
+
+class Boolean : public Value {
+ public:
+  static Handle<Value> New(bool val);
+  bool BooleanValue();
+
+ private:
+  explicit Boolean(bool val);
+  Value* CloneInto(void* storage);
+  bool val_;
 };
 
 class Number : public Value {
@@ -90,17 +175,293 @@ class Number : public Value {
 
  private:
   explicit Number(double val);
+  Value* CloneInto(void* storage);
   double val_;
 };
 
+// Host memory handed to the engine without copying. The release callback
+// runs once neither the host nor the engine use it anymore, which may be
+// on the thread running the engine's GC.
+class ExternalBuffer : public ThreadSafeRefCounted {
+ public:
+  typedef void (*release_callback)(void* user_data);
+
+  static Handle<ExternalBuffer> New(
+    const char * data,
+    size_t length,
+    release_callback release,
+    void* user_data);
+
+  // Memory scripts may write to, used by array buffers.
+  static Handle<ExternalBuffer> New(
+    void* data,
+    size_t length,
+    release_callback release,
+    void* user_data);
+  ~ExternalBuffer();
+
+  const char * Data();
+  void* Bytes();
+  size_t Length();
+
+  // Only ASCII strings can be external in V8, others are copied. The data
+  // is scanned on the first call.
+  bool IsAscii();
+
+ private:
+  ExternalBuffer(
+    char * data,
+    size_t length,
+    release_callback release,
+    void* user_data);
+
+  enum Encoding {
+    ENCODING_UNKNOWN,
+    ENCODING_ASCII,
+    ENCODING_OTHER
+  };
+
+  char * data_;
+  size_t length_;
+  release_callback release_;
+  void* user_data_;
+  std::atomic<int> encoding_;
+};
+
 class String : public Value {
  public:
   static Handle<Value> New(const std::string& val);
+
+  // Strings whose characters stay in host memory, handing them to the
+  // engine does not copy them. The data is UTF-8.
+  static Handle<Value> NewExternal(Handle<ExternalBuffer> buffer);
+  static Handle<Value> NewExternal(
+    const char * data,
+    size_t length,
+    ExternalBuffer::release_callback release,
+    void* user_data);
+  static Handle<Value> NewExternal(std::string&& val);
+
+#ifdef BASTIAN_V8
+  // Copies the characters of the string.
+  static Handle<Value> Copy(const v8::Local<v8::String>& v8_string);
+
+  // Keeps a reference to the string in its isolate instead, the characters
+  // are only read when asked for. Used for native function arguments.
+  static Handle<Value> Wrap(const v8::Local<v8::String>& v8_string);
+
+  // Copies the characters of a wrapped string which is still referenced
+  // elsewhere when the native call it was wrapped for returns, the copy
+  // stays readable on any thread and once the engine is gone.
+  static void Unwrap(const Handle<Value>& value);
+  ~String();
+#endif
+
   std::string StringValue();
 
+  // No copy is made for strings built from the host and for external
+  // strings. Other wrapped strings are written to a buffer owned by the
+  // thread, the view is then valid until the next one is taken.
+  string_view StringView();
+
  private:
   explicit String(const std::string& val);
+  String();
+#ifdef BASTIAN_V8
+  v8::Local<v8::Value> Extract();
+  BoundPersistent<v8::String> v8_string_;
+#endif
+#ifdef BASTIAN_JSC
+  JSValueRef Extract();
+#endif
   std::string val_;
+  Handle<ExternalBuffer> external_;
+};
+
+// Elements of a script array are converted one at a time when read, the
+// elements of an array built by the host when it is handed to the engine.
+class Array : public Value {
+ public:
+  static Handle<Value> New(const std::vector<Handle<Value>>& elements);
+#ifdef BASTIAN_V8
+  static Handle<Value> New(const v8::Local<v8::Array>& v8_array);
+#endif
+#ifdef BASTIAN_JSC
+  static Handle<Value> New(JSContextRef context_ref, JSObjectRef jsc_object);
+#endif
+
+  // NULL when the value is not an array.
+  static Array* Cast(const Handle<Value>& value);
+  ~Array();
+
+  size_t Length();
+
+  // Undefined past the last element and for reads which throw.
+  Handle<Value> Get(size_t index);
+  bool ToVector(std::vector<double>* values);
+
+ private:
+  explicit Array(const std::vector<Handle<Value>>& elements);
+#ifdef BASTIAN_V8
+  v8::Local<v8::Value> Extract();
+  BoundPersistent<v8::Array> v8_array_;
+#endif
+#ifdef BASTIAN_JSC
+  JSValueRef Extract();
+  JSObjectRef jsc_object_;
+  JSGlobalContextRef jsc_context_;
+#endif
+  std::vector<Handle<Value>> elements_;
+};
+
+// Bytes shared with the engine, neither side copies them and the writes
+// of one are seen by the other. Buffers coming from scripts are detached
+// from the engine's heap on the way, their memory then belongs to the
+// ExternalBuffer. With V8 this needs the allocator bastian::Init installs,
+// such buffers read as null when V8 was set up by other means. The memory
+// is released once the host and every script object viewing it are done
+// with it, objects still alive when their isolate is disposed keep it
+// forever.
+class ArrayBuffer : public Value {
+ public:
+  // Zero filled memory owned by the buffer.
+  static Handle<Value> New(size_t byte_length);
+  static Handle<Value> New(Handle<ExternalBuffer> buffer);
+#ifdef BASTIAN_V8
+  static Handle<Value> New(const v8::Local<v8::ArrayBuffer>& v8_buffer);
+#endif
+#ifdef BASTIAN_JSC
+  static Handle<Value> New(JSContextRef context_ref, JSObjectRef jsc_object);
+#endif
+
+  // NULL when the value is not an array buffer.
+  static ArrayBuffer* Cast(const Handle<Value>& value);
+  ~ArrayBuffer();
+
+  Handle<ExternalBuffer> Buffer();
+  void* Data();
+  size_t ByteLength();
+
+ private:
+  explicit ArrayBuffer(Handle<ExternalBuffer> buffer);
+#ifdef BASTIAN_V8
+  v8::Local<v8::Value> Extract();
+  BoundPersistent<v8::ArrayBuffer> v8_buffer_;
+#endif
+#ifdef BASTIAN_JSC
+  JSValueRef Extract();
+  JSObjectRef jsc_object_;
+  JSGlobalContextRef jsc_context_;
+#endif
+  Handle<ExternalBuffer> buffer_;
+};
+
+// Elements of one numeric type viewing the memory of an array buffer, in
+// host byte order.
+class TypedArray : public Value {
+ public:
+#ifdef BASTIAN_V8
+  static Handle<Value> New(const v8::Local<v8::TypedArray>& v8_array);
+#endif
+#ifdef BASTIAN_JSC
+  static Handle<Value> New(JSContextRef context_ref, JSObjectRef jsc_object);
+#endif
+  ~TypedArray();
+
+  Handle<ExternalBuffer> Buffer();
+  size_t ByteOffset();
+  size_t Length();
+  bool ToVector(std::vector<double>* values);
+
+ protected:
+  TypedArray(
+    Type type,
+    Handle<ExternalBuffer> buffer,
+    size_t byte_offset,
+    size_t length);
+
+  // Null when the view is misaligned or does not fit in the buffer.
+  static Handle<Value> New(
+    Type type,
+    Handle<ExternalBuffer> buffer,
+    size_t byte_offset,
+    size_t length);
+
+  // NULL when the value is not an array of the type.
+  static TypedArray* Cast(const Handle<Value>& value, Type type);
+  void* Elements();
+
+ private:
+  static size_t ElementSize(Type type);
+#ifdef BASTIAN_V8
+  v8::Local<v8::Value> Extract();
+  BoundPersistent<v8::TypedArray> v8_array_;
+#endif
+#ifdef BASTIAN_JSC
+  JSValueRef Extract();
+  JSObjectRef jsc_object_;
+  JSGlobalContextRef jsc_context_;
+#endif
+  Handle<ExternalBuffer> buffer_;
+  size_t byte_offset_;
+  size_t length_;
+};
+
+class Float64Array : public TypedArray {
+  friend class TypedArray;
+
+ public:
+  static Handle<Value> New(size_t length);
+  static Handle<Value> New(
+    Handle<ExternalBuffer> buffer,
+    size_t byte_offset,
+    size_t length);
+  static Float64Array* Cast(const Handle<Value>& value);
+  double* Data();
+
+ private:
+  Float64Array(
+    Handle<ExternalBuffer> buffer,
+    size_t byte_offset,
+    size_t length);
+};
+
+class Int32Array : public TypedArray {
+  friend class TypedArray;
+
+ public:
+  static Handle<Value> New(size_t length);
+  static Handle<Value> New(
+    Handle<ExternalBuffer> buffer,
+    size_t byte_offset,
+    size_t length);
+  static Int32Array* Cast(const Handle<Value>& value);
+  int32_t* Data();
+
+ private:
+  Int32Array(
+    Handle<ExternalBuffer> buffer,
+    size_t byte_offset,
+    size_t length);
+};
+
+class Uint8Array : public TypedArray {
+  friend class TypedArray;
+
+ public:
+  static Handle<Value> New(size_t length);
+  static Handle<Value> New(
+    Handle<ExternalBuffer> buffer,
+    size_t byte_offset,
+    size_t length);
+  static Uint8Array* Cast(const Handle<Value>& value);
+  uint8_t* Data();
+
+ private:
+  Uint8Array(
+    Handle<ExternalBuffer> buffer,
+    size_t byte_offset,
+    size_t length);
 };
 
 class Function : public Value {
@@ -109,45 +470,223 @@ class Function : public Value {
   static Handle<Value> New(const v8::Local<v8::Function>&);
 #endif
 #ifdef BASTIAN_JSC
-  static Handle<Value> New(JSObjectRef jsc_object);
+  static Handle<Value> New(JSContextRef context_ref, JSObjectRef jsc_object);
 #endif
 
-  void Call(const std::vector<Handle<Value>>& arguments);
+  ~Function();
+  Handle<Value> Call(const std::vector<Handle<Value>>& arguments);
+  std::vector<Handle<Value>> CallBatch(
+    const std::vector<std::vector<Handle<Value>>>& calls);
  private:
 #ifdef BASTIAN_V8
   Function(const v8::Local<v8::Function>&);
-  v8::Persistent<v8::Function> v8_function_;
+  BoundPersistent<v8::Function> v8_function_;
+  v8::Local<v8::Value> Extract();
 #endif
 #ifdef BASTIAN_JSC
-  Function(JSObjectRef jsc_object);
+  friend class CallSite;
+
+  Function(JSContextRef context_ref, JSObjectRef jsc_object);
   JSObjectRef jsc_object_;
+  JSGlobalContextRef jsc_context_;
+  JSValueRef Extract();
 #endif
 };
 
 class JSCObjectContext;
 class V8ObjectContext;
 
+// Objects coming from scripts keep a reference to the script object, a
+// property is only converted when it is first read and the converted
+// value is cached. Properties are read in the context which created the
+// object, after the run is over. Objects built from properties are
+// converted whole when handed to the engine.
 class Object : public Value {
  public:
 #ifdef BASTIAN_V8
   static Handle<Value> New(void (*obj_generator)(Handle<V8ObjectContext>));
+  static Handle<Value> New(const v8::Local<v8::Object>& v8_object);
 #endif
 #ifdef BASTIAN_JSC
   static Handle<Value> New(void (*jsc_obj_generator)(Handle<JSCObjectContext>));
+  static Handle<Value> New(JSContextRef context_ref, JSObjectRef jsc_object);
 #endif
+
+  // Object built by the host, in the order of the properties. A repeated
+  // key keeps its first position and its last value.
+  static Handle<Value> New(
+    const std::vector<std::pair<std::string, Handle<Value>>>& properties);
+
+  // NULL when the value is not an object.
+  static Object* Cast(const Handle<Value>& value);
+  ~Object();
+
+  // Undefined for missing properties and for reads which throw. Changes
+  // made by scripts after the first read of a property are not seen.
+  Handle<Value> Get(const std::string& key);
+
+  // Own enumerable property names, read once.
+  const std::vector<std::string>& Keys();
+
  private:
+  friend class JSONWriter;
+
+  // Get telling the JSON writer whether the read threw.
+  Handle<Value> Get(const std::string& key, bool* threw);
+
+  // What JSON.stringify writes in place of a script object: the result of
+  // its toJSON method, or the primitive value of a Number, String or
+  // Boolean object. NULL when the object is written as it is. Sets threw
+  // when reading or calling toJSON throws, the whole text is then
+  // dropped as JSON.stringify would throw.
+  Handle<Value> JSONValue(const std::string& key, bool* threw);
+
 #ifdef BASTIAN_V8
   explicit Object(void (*obj_generator)(Handle<V8ObjectContext>));
-  v8::Persistent<v8::Object> v8_object_;
+  BoundPersistent<v8::Object> v8_object_;
   v8::Local<v8::Value> Extract();
 #endif
 #ifdef BASTIAN_JSC
   explicit Object(void (*jsc_obj_generator)(Handle<JSCObjectContext>));
   JSObjectRef jsc_object_;
+  JSGlobalContextRef jsc_context_;
   JSValueRef Extract();
 #endif
+  Object();
+
+  std::map<std::string, Handle<Value>> properties_;
+  std::vector<std::string> keys_;
+  bool keys_read_;
 };
 
+// Null, undefined, booleans and numbers are stored in the handle itself,
+// creating or copying them allocates nothing. Other values are reference
+// counted as with any Handle.
+template<>
+class Handle<Value> {
+  friend class Boolean;
+  friend class NullValue;
+  friend class Number;
+  friend class UndefinedValue;
+
+ public:
+  static inline bool Is(Value* resource, const Handle<Value>& reference) {
+    return resource == reference.Get();
+  }
+
+  inline Handle<Value> & operator= (const Handle<Value> & other) {
+    if (this != &other) {
+      Reset();
+      CopyFrom(other);
+    }
+
+    return *this;
+  }
+
+  inline Handle<Value> & operator= (Handle<Value> && other) {
+    if (this != &other) {
+      Reset();
+      MoveFrom(&other);
+    }
+
+    return *this;
+  }
+
+  inline explicit Handle() : boxed_(NULL), inline_(false) {}
+
+  inline explicit Handle(Value* resource) : boxed_(resource), inline_(false) {
+    if (boxed_ != NULL) {
+      boxed_->Retain();
+    }
+  }
+
+  inline Handle(const Handle<Value>& other) : boxed_(NULL), inline_(false) {
+    CopyFrom(other);
+  }
+
+  inline Handle(Handle<Value>&& other) : boxed_(NULL), inline_(false) {
+    MoveFrom(&other);
+  }
+
+  inline ~Handle() {
+    Reset();
+  }
+
+  inline Value* operator->() const {
+    return Get();
+  }
+
+  inline void Clear() {
+    Reset();
+  }
+
+ private:
+  inline Value* Get() const {
+    return inline_ ? reinterpret_cast<Value*>(storage_) : boxed_;
+  }
+
+  inline void* Storage() {
+    inline_ = true;
+    return storage_;
+  }
+
+  inline void CopyFrom(const Handle<Value>& other) {
+    if (other.inline_) {
+      other.Get()->CloneInto(Storage());
+    } else if (other.boxed_ != NULL) {
+      boxed_ = other.boxed_;
+      boxed_->Retain();
+    }
+  }
+
+  inline void MoveFrom(Handle<Value>* other) {
+    if (other->inline_) {
+      CopyFrom(*other);
+      other->Reset();
+    } else {
+      boxed_ = other->boxed_;
+      other->boxed_ = NULL;
+    }
+  }
+
+  inline void Reset() {
+    if (inline_) {
+      Get()->~Value();
+      inline_ = false;
+      boxed_ = NULL;
+    } else if (boxed_ != NULL) {
+      Value* previous = boxed_;
+
+      boxed_ = NULL;
+
+      if (previous->Release()) {
+        delete previous;
+      }
+    }
+  }
+
+  union {
+    Value* boxed_;
+    alignas(Number) mutable char storage_[sizeof(Number)];
+  };
+  bool inline_;
+};
+
+inline Handle<Value> Value::Call(
+    const std::vector<Handle<Value>>& arguments) {
+  return UndefinedValue::New();
+}
+
+inline std::vector<Handle<Value>> Value::CallBatch(
+    const std::vector<std::vector<Handle<Value>>>& calls) {
+  return std::vector<Handle<Value>>(calls.size(), UndefinedValue::New());
+}
+
+inline Handle<Value> Value::Call() {
+  std::vector<Handle<Value>> arguments;
+  return Call(arguments);
+}
+
 }  // namespace bastian
 
 #endif  // BASTIAN_VALUE_H_
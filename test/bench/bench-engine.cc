@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include <bastian.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+#ifdef BASTIAN_V8
+#define ENGINE_BENCH_SUITE V8EngineBench
+#endif
+
+#ifdef BASTIAN_JSC
+#define ENGINE_BENCH_SUITE JSCEngineBench
+#endif
+
+BASTIAN_FUNCTION(SoakEcho) (bastian::FunctionRef func) {
+  func->SetResult(func->GetArgument(0));
+}
+
+BASTIAN_OBJECT(SoakGlobal) (bastian::ObjectRef obj) {
+  obj->Export("echo", SoakEcho);
+  obj->Export("foobar", bastian::Number::New(42));
+}
+
+// No-op callbacks, one straight on the engine API and one through the
+// BASTIAN_FUNCTION wrapper.
+#ifdef BASTIAN_V8
+static void RawNoop(const v8::FunctionCallbackInfo<v8::Value>&) {}
+#endif
+
+#ifdef BASTIAN_JSC
+static JSValueRef RawNoop(
+    JSContextRef context_ref,
+    JSObjectRef,
+    JSObjectRef,
+    size_t,
+    const JSValueRef*,
+    JSValueRef*) {
+  return JSValueMakeUndefined(context_ref);
+}
+#endif
+
+BASTIAN_FUNCTION(WrappedNoop) (bastian::FunctionRef func) {
+}
+
+BASTIAN_OBJECT(CallGlobal) (bastian::ObjectRef obj) {
+  obj->Export("raw", RawNoop);
+  obj->Export("wrapped", WrappedNoop);
+}
+
+// Resident set size in KB, 0 where /proc is not available.
+static long ResidentKilobytes() {
+  long size = 0;
+  long pages = 0;
+  FILE* statm = std::fopen("/proc/self/statm", "r");
+
+  if (statm != NULL) {
+    // Total program size first, then the resident pages.
+    if (std::fscanf(statm, "%ld %ld", &size, &pages) != 2) {
+      pages = 0;
+    }
+
+    std::fclose(statm);
+  }
+
+  return pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// Runs a script exchanging values with the host 10M times (or
+// BASTIAN_SOAK_RUNS) and checks that the resident size stays flat once
+// warmed up.
+TEST(ENGINE_BENCH_SUITE, Soak) {
+  long runs = 10 * 1000 * 1000;
+  const char* runs_env = std::getenv("BASTIAN_SOAK_RUNS");
+
+  if (runs_env != NULL) {
+    runs = std::atol(runs_env);
+  }
+
+  bastian::EngineOptions options;
+  options.context_pool_size = 1;
+  options.context_policy = bastian::EngineOptions::CONTEXT_RESET;
+  bastian::Handle<bastian::Engine> engine =
+    bastian::Engine::New(SoakGlobal, options);
+  bastian::Handle<bastian::Script> script =
+    engine->Compile("echo('soak') + echo(foobar)", "soak.js");
+  long step = runs / 10 > 0 ? runs / 10 : 1;
+  long warm_rss = 0;
+
+  std::printf("%12s %12s\n", "runs", "rss (KB)");
+
+  for (long run = 1; run <= runs; ++run) {
+    EXPECT_EQ(6u, engine->Run(script)->StringValue().size());
+
+    if (run % step == 0) {
+      long rss = ResidentKilobytes();
+
+      if (warm_rss == 0) {
+        warm_rss = rss;
+      }
+
+      std::printf("%12ld %12ld\n", run, rss);
+    }
+  }
+
+  // Allow for the heap settling, not for a growth proportional to runs.
+  EXPECT_LT(ResidentKilobytes(), warm_rss + warm_rss / 4);
+}
+
+// Times 10M calls of a no-op native function from a script, straight on
+// the engine API and through BASTIAN_FUNCTION. The two alternate over a few
+// rounds and the best round of each is kept. The wrapper should add little
+// more than the call arena scope.
+TEST(ENGINE_BENCH_SUITE, NativeCallOverhead) {
+  const int kCalls = 10 * 1000 * 1000;
+  const int kRounds = 3;
+  const char* names[] = { "raw", "wrapped" };
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(CallGlobal);
+  bastian::Handle<bastian::Script> scripts[2];
+  double best[2] = { 0, 0 };
+
+  // The first script compiled by an engine runs markedly slower, keep it
+  // out of the comparison.
+  engine->Compile("0", "warmup.js");
+
+  for (int i = 0; i < 2; ++i) {
+    std::string source = std::string("for (var i = 0; i < ") +
+      std::to_string(kCalls) + "; ++i) " + names[i] + "(i); i";
+    scripts[i] = engine->Compile(source.c_str(), "calls.js");
+  }
+
+  for (int round = 0; round < kRounds; ++round) {
+    for (int i = 0; i < 2; ++i) {
+      std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+      EXPECT_EQ(kCalls, engine->Run(scripts[i])->NumberValue());
+      std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+      if (round == 0 || elapsed.count() < best[i]) {
+        best[i] = elapsed.count();
+      }
+    }
+  }
+
+  std::printf("%10s %14s\n", "callback", "ns/call");
+
+  for (int i = 0; i < 2; ++i) {
+    std::printf("%10s %14.1f\n", names[i], best[i] * 1e9 / kCalls);
+  }
+
+  // Loose bound so that a loaded machine does not fail it.
+  EXPECT_LT(best[1], best[0] * 3);
+}
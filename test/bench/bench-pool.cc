@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include <bastian.h>
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#ifdef BASTIAN_V8
+#define POOL_BENCH_SUITE V8EnginePoolBench
+#endif
+
+#ifdef BASTIAN_JSC
+#define POOL_BENCH_SUITE JSCEnginePoolBench
+#endif
+
+static const int kRunsPerCaller = 2000;
+
+class BenchEnvironment : public ::testing::Environment {
+ public:
+  void SetUp() {
+    bastian::Init();
+  }
+
+  void TearDown() {
+    bastian::Shutdown(true);
+  }
+};
+
+static ::testing::Environment* const bench_environment =
+  ::testing::AddGlobalTestEnvironment(new BenchEnvironment());
+
+BASTIAN_OBJECT(BenchGlobal) (bastian::ObjectRef obj) {
+  obj->Export("foobar", bastian::Number::New(42));
+}
+
+// Runs the same small script through pools of 1 up to hardware_concurrency
+// isolates, with as many caller threads as isolates.
+TEST(POOL_BENCH_SUITE, Scaling) {
+  int max_size = static_cast<int>(std::thread::hardware_concurrency());
+
+  if (max_size <= 0) {
+    max_size = 1;
+  }
+
+  std::printf("%8s %14s\n", "isolates", "runs/s");
+
+  for (int size = 1; size <= max_size; ++size) {
+    bastian::Handle<bastian::EnginePool> pool =
+      bastian::EnginePool::New(BenchGlobal, size);
+    std::vector<std::thread> callers;
+    std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+
+    for (int caller = 0; caller < size; ++caller) {
+      callers.push_back(std::thread([&pool] {
+        for (int run = 0; run < kRunsPerCaller; ++run) {
+          pool->Run("var total = 0; for (var i = 0; i < 100; i++) total += foobar; total");
+        }
+      }));
+    }
+
+    for (unsigned index = 0; index < callers.size(); ++index) {
+      callers.at(index).join();
+    }
+
+    std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+    std::printf("%8d %14.0f\n", size, size * kRunsPerCaller / elapsed.count());
+  }
+}
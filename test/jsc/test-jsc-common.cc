@@ -1,3 +1,4 @@
+#include <gtest/gtest.h>
 #include "test-jsc-common.h"
 
 TestContext::TestContext() {}
@@ -43,3 +44,28 @@ void TestContext::RunJS(const char * rawSource) {
   JSValueRef exception = NULL;
   JSEvaluateScript(ctx, script, NULL, NULL, 1, &exception);
 }
+
+
+BASTIAN_OBJECT(TestGlobal) (bastian::ObjectRef obj) {
+}
+
+// Every test binary shares one initialized process, the engine created
+// here keeps it in use until the tests are over.
+class TestEnvironment : public ::testing::Environment {
+ public:
+  void SetUp() {
+    bastian::Init();
+    engine_ = bastian::Engine::New(TestGlobal);
+  }
+
+  void TearDown() {
+    engine_->Dispose();
+    bastian::Shutdown();
+  }
+
+ private:
+  bastian::Handle<bastian::Engine> engine_;
+};
+
+static ::testing::Environment* const test_environment =
+  ::testing::AddGlobalTestEnvironment(new TestEnvironment());
@@ -0,0 +1,6 @@
+// Prelude baked into the snapshot of the test build.
+var prelude = {
+  double: function (value) {
+    return value * 2;
+  }
+};
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include <bastian.h>
+
+#ifdef BASTIAN_V8
+#define ARENA_TEST_SUITE V8CallArena
+#endif
+
+#ifdef BASTIAN_JSC
+#define ARENA_TEST_SUITE JSCCallArena
+#endif
+
+
+static bastian::Handle<bastian::Value> kept = bastian::NullValue::New();
+
+BASTIAN_FUNCTION(ArenaKeep) (bastian::FunctionRef func) {
+  kept = func->GetArgument(0);
+}
+
+BASTIAN_FUNCTION(ArenaTwice) (bastian::FunctionRef func) {
+  double val = func->GetArgument(0)->NumberValue();
+  func->SetResult(bastian::Number::New(val * 2));
+}
+
+BASTIAN_OBJECT(ArenaGlobal) (bastian::ObjectRef obj) {
+  obj->Export("keep", ArenaKeep);
+  obj->Export("twice", ArenaTwice);
+}
+
+TEST(ARENA_TEST_SUITE, RewoundBetweenCalls) {
+  void* first;
+  void* second;
+
+  {
+    bastian::CallArena::Scope scope;
+    first = bastian::CallArena::Allocate(32);
+    bastian::CallArena::Free(first);
+  }
+
+  {
+    bastian::CallArena::Scope scope;
+    second = bastian::CallArena::Allocate(32);
+    bastian::CallArena::Free(second);
+  }
+
+  EXPECT_EQ(first, second);
+}
+
+TEST(ARENA_TEST_SUITE, ValuesOutliveTheCall) {
+  bastian::Handle<bastian::Value> kept_value;
+  void* first;
+  void* second;
+
+  {
+    bastian::CallArena::Scope scope;
+    first = bastian::CallArena::Allocate(32);
+    kept_value = bastian::String::New("kept");
+    bastian::CallArena::Free(first);
+  }
+
+  {
+    bastian::CallArena::Scope scope;
+    second = bastian::CallArena::Allocate(32);
+    bastian::CallArena::Free(second);
+  }
+
+  EXPECT_EQ(first, second);
+  EXPECT_STREQ("kept", kept_value->StringValue().c_str());
+}
+
+TEST(ARENA_TEST_SUITE, NestedScopes) {
+  bastian::CallArena::Scope outer;
+  void* first = bastian::CallArena::Allocate(16);
+
+  {
+    bastian::CallArena::Scope inner;
+    void* second = bastian::CallArena::Allocate(16);
+    EXPECT_NE(first, second);
+    bastian::CallArena::Free(second);
+  }
+
+  void* third = bastian::CallArena::Allocate(16);
+  EXPECT_NE(first, third);
+  bastian::CallArena::Free(first);
+  bastian::CallArena::Free(third);
+}
+
+TEST(ARENA_TEST_SUITE, LargeAndOutOfScopeAllocations) {
+  void* outside = bastian::CallArena::Allocate(32);
+  bastian::CallArena::Free(outside);
+
+  bastian::CallArena::Scope scope;
+  void* large = bastian::CallArena::Allocate(64 * 1024);
+  static_cast<char*>(large)[64 * 1024 - 1] = 1;
+  bastian::CallArena::Free(large);
+}
+
+TEST(ARENA_TEST_SUITE, ArgumentsKeptAcrossNativeCalls) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(ArenaGlobal);
+
+  EXPECT_EQ(42, engine->Run(
+    "var total = 0; for (var i = 0; i < 10000; i++) total = twice(21); total")
+    ->NumberValue());
+
+  engine->Run("keep('kept'); for (var i = 0; i < 10000; i++) twice(i)");
+  EXPECT_STREQ("kept", kept->StringValue().c_str());
+  kept = bastian::NullValue::New();
+}
+
+TEST(ARENA_TEST_SUITE, RewoundAfterFillingBlocks) {
+  void* first;
+  void* second;
+
+  {
+    bastian::CallArena::Scope scope;
+
+    for (int index = 0; index < 100; ++index) {
+      static_cast<char*>(bastian::CallArena::Allocate(1024))[1023] = 1;
+    }
+  }
+
+  {
+    bastian::CallArena::Scope scope;
+    first = bastian::CallArena::Allocate(32);
+  }
+
+  {
+    bastian::CallArena::Scope scope;
+    second = bastian::CallArena::Allocate(32);
+  }
+
+  EXPECT_EQ(first, second);
+}
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include <bastian.h>
+
+#include <string>
+
+#ifdef BASTIAN_V8
+#define BIND_TEST_SUITE V8Bind
+#endif
+
+#ifdef BASTIAN_JSC
+#define BIND_TEST_SUITE JSCBind
+#endif
+
+
+static double recorded = 0;
+
+static double Add(double a, double b) {
+  return a + b;
+}
+
+static int32_t Twice(int32_t value) {
+  return value * 2;
+}
+
+static bool Negate(bool value) {
+  return !value;
+}
+
+static std::string Greet(const std::string& name) {
+  return "hello " + name;
+}
+
+static uint32_t Length(bastian::string_view text) {
+  return static_cast<uint32_t>(text.length);
+}
+
+static void Record(double value) {
+  recorded = value;
+}
+
+static bastian::Handle<bastian::Value> Identity(
+    bastian::Handle<bastian::Value> value) {
+  return value;
+}
+
+BASTIAN_OBJECT(BindGlobal) (bastian::ObjectRef obj) {
+  obj->Export("add", BASTIAN_BIND(Add));
+  obj->Export("twice", BASTIAN_BIND(Twice));
+  obj->Export("negate", BASTIAN_BIND(Negate));
+  obj->Export("greet", BASTIAN_BIND(Greet));
+  obj->Export("length", BASTIAN_BIND(Length));
+  obj->Export("record", BASTIAN_BIND(Record));
+  obj->Export("identity", BASTIAN_BIND(Identity));
+}
+
+TEST(BIND_TEST_SUITE, Numbers) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(BindGlobal);
+
+  EXPECT_EQ(3.5, engine->Run("add(1, 2.5)")->NumberValue());
+  EXPECT_EQ(6, engine->Run("add('2', 4)")->NumberValue());
+  EXPECT_TRUE(engine->Run("isNaN(add(1))")->BooleanValue());
+  EXPECT_EQ(-2, engine->Run("twice(4294967295)")->NumberValue());
+  EXPECT_EQ(14, engine->Run("twice(7.9)")->NumberValue());
+}
+
+TEST(BIND_TEST_SUITE, BooleansAndVoid) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(BindGlobal);
+
+  EXPECT_TRUE(engine->Run("negate(0)")->BooleanValue());
+  EXPECT_TRUE(engine->Run("record(12) === undefined")->BooleanValue());
+  EXPECT_EQ(12, recorded);
+}
+
+TEST(BIND_TEST_SUITE, Strings) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(BindGlobal);
+
+  EXPECT_STREQ("hello w\xc3\xb6rld",
+    engine->Run("greet('w\\u00f6rld')")->StringValue().c_str());
+  EXPECT_STREQ("hello 42", engine->Run("greet(42)")->StringValue().c_str());
+  EXPECT_EQ(6, engine->Run("length('h\\u00e9llo')")->NumberValue());
+
+  std::vector<bastian::Handle<bastian::Value>> arguments;
+  arguments.push_back(bastian::String::NewExternal(std::string("external")));
+
+  EXPECT_EQ(8, engine->Run(engine->Compile(
+    "return length(arguments[0]);"), arguments)->NumberValue());
+}
+
+TEST(BIND_TEST_SUITE, Values) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(BindGlobal);
+
+  EXPECT_STREQ("b", engine->Run("identity({ a: 'b' }).a")->StringValue().c_str());
+  EXPECT_STREQ("text", engine->Run("identity('text')")->StringValue().c_str());
+}
+
+TEST(BIND_TEST_SUITE, ThrowingConversions) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(BindGlobal);
+
+  recorded = 0;
+  EXPECT_STREQ("caught 1", engine->Run(
+    "try { greet({ toString: function () { throw 1; } }); }"
+    "catch (error) { 'caught ' + error; }")->StringValue().c_str());
+  EXPECT_STREQ("caught 2", engine->Run(
+    "try { record({ valueOf: function () { throw 2; } }); }"
+    "catch (error) { 'caught ' + error; }")->StringValue().c_str());
+  EXPECT_EQ(0, recorded);
+  EXPECT_STREQ("hello ", engine->Run(
+    "greet({ toString: function () { return ''; } })")->StringValue().c_str());
+}
+
+TEST(BIND_TEST_SUITE, ConversionOrder) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(BindGlobal);
+
+  EXPECT_STREQ("a,b", engine->Run(
+    "var seen = [];"
+    "add({ valueOf: function () { seen.push('a'); return 1; } },"
+    "    { valueOf: function () { seen.push('b'); return 2; } });"
+    "seen.join()")->StringValue().c_str());
+  EXPECT_STREQ("a", engine->Run(
+    "var seen = [];"
+    "try {"
+    "  add({ valueOf: function () { seen.push('a'); throw 1; } },"
+    "      { valueOf: function () { seen.push('b'); return 2; } });"
+    "} catch (error) {}"
+    "seen.join()")->StringValue().c_str());
+}
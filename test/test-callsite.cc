@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <bastian.h>
+
+#include <cstring>
+
+#ifdef BASTIAN_V8
+#define CALLSITE_TEST_SUITE V8CallSite
+#endif
+
+#ifdef BASTIAN_JSC
+#define CALLSITE_TEST_SUITE JSCCallSite
+#endif
+
+
+// Calls its argument with true then false, and returns the last result.
+BASTIAN_FUNCTION(CallFailingFirst) (bastian::FunctionRef func) {
+  bastian::CallSite site(func->GetArgument(0));
+
+  site.Invoke(bastian::Boolean::New(true));
+  func->SetResult(site.Invoke(bastian::Boolean::New(false)));
+}
+
+BASTIAN_OBJECT(CallSiteGlobal) (bastian::ObjectRef obj) {
+  obj->Export("base", bastian::Number::New(100));
+  obj->Export("callFailingFirst", CallFailingFirst);
+}
+
+TEST(CALLSITE_TEST_SUITE, InvokeWithResult) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(CallSiteGlobal);
+  bastian::Handle<bastian::Value> add = engine->Run(
+    "(function (a, b) { return a + b; })");
+  bastian::CallSite site(add);
+
+  EXPECT_EQ(3, site.Invoke(1, 2)->NumberValue());
+  EXPECT_STREQ("2x", site.Invoke(
+    bastian::Number::New(2), bastian::String::New("x"))->StringValue().c_str());
+  EXPECT_EQ(7, add->Call(std::vector<bastian::Handle<bastian::Value>>(
+    2, bastian::Number::New(3.5)))->NumberValue());
+}
+
+TEST(CALLSITE_TEST_SUITE, ReusedForEveryRecord) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(CallSiteGlobal);
+  bastian::Handle<bastian::Value> accumulate = engine->Run(
+    "var total = base; (function (value) { total += value; return total; })");
+  bastian::Handle<bastian::Value> last;
+  bastian::CallSite site(accumulate);
+
+  for (int record = 0; record < 1000; ++record) {
+    last = site.Invoke(record);
+  }
+
+  EXPECT_EQ(100 + 499500, last->NumberValue());
+}
+
+TEST(CALLSITE_TEST_SUITE, Receiver) {
+  static const char config[] = "{\"k\": 5}";
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(CallSiteGlobal);
+  bastian::Handle<bastian::Value> read = engine->Run(
+    "(function () { return this.k === undefined ? this.base : this.k; })");
+
+  {
+    bastian::CallSite site(read);
+    EXPECT_EQ(100, site.Invoke()->NumberValue());
+  }
+
+  bastian::CallSite site(read,
+    bastian::Value::FromJSON(config, std::strlen(config)));
+  EXPECT_EQ(5, site.Invoke()->NumberValue());
+}
+
+TEST(CALLSITE_TEST_SUITE, CallAfterOtherEngine) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(CallSiteGlobal);
+  bastian::Handle<bastian::Value> read = engine->Run(
+    "var own = 'first'; (function (suffix) { return own + suffix; })");
+  bastian::Handle<bastian::Engine> other =
+    bastian::Engine::New(CallSiteGlobal);
+
+  other->Run("var own = 'second'");
+  other->Dispose();
+
+  EXPECT_STREQ("first!",
+    bastian::CallSite(read).Invoke(bastian::String::New("!"))
+      ->StringValue().c_str());
+}
+
+TEST(CALLSITE_TEST_SUITE, UndefinedResults) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(CallSiteGlobal);
+  bastian::Handle<bastian::Value> fail = engine->Run(
+    "(function () { throw new Error('failed'); })");
+
+  EXPECT_TRUE(bastian::CallSite(fail).Invoke()->IsUndefined());
+  EXPECT_TRUE(bastian::CallSite(bastian::Number::New(1)).Invoke(1)->IsUndefined());
+  EXPECT_TRUE(bastian::Number::New(1)->Call()->IsUndefined());
+}
+
+TEST(CALLSITE_TEST_SUITE, ThrowFromNativeFunction) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(CallSiteGlobal);
+  bastian::Handle<bastian::Value> result = engine->Run(
+    "callFailingFirst(function (fail) {"
+    "  if (fail) { throw new Error('failed'); }"
+    "  return 'passed';"
+    "}) + ' then ' + callFailingFirst(Math.max)");
+
+  EXPECT_STREQ("passed then 0", result->StringValue().c_str());
+}
+
+TEST(CALLSITE_TEST_SUITE, InvokeBatch) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(CallSiteGlobal);
+  bastian::Handle<bastian::Value> label = engine->Run(
+    "(function (name, value) { return name + '=' + value; })");
+  std::vector<std::vector<bastian::Handle<bastian::Value>>> calls(1000);
+
+  for (int index = 0; index < 1000; ++index) {
+    calls[index].push_back(bastian::String::New("k"));
+    calls[index].push_back(bastian::Number::New(index));
+  }
+
+  std::vector<bastian::Handle<bastian::Value>> results = label->CallBatch(calls);
+
+  ASSERT_EQ(1000u, results.size());
+  EXPECT_STREQ("k=0", results[0]->StringValue().c_str());
+  EXPECT_STREQ("k=999", results[999]->StringValue().c_str());
+  EXPECT_EQ(2u, bastian::Number::New(1)->CallBatch(
+    std::vector<std::vector<bastian::Handle<bastian::Value>>>(2)).size());
+}
+
+TEST(CALLSITE_TEST_SUITE, InvokeColumns) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(CallSiteGlobal);
+  bastian::Handle<bastian::Value> scale = engine->Run(
+    "(function (value, factor) { return value < 0 ? 'skip' : value * factor; })");
+  std::vector<std::vector<double>> columns(2);
+  std::vector<double> results;
+
+  for (int row = 0; row < 600; ++row) {
+    columns[0].push_back(row - 1);
+    columns[1].push_back(2);
+  }
+
+  columns[1].pop_back();
+  bastian::CallSite(scale).InvokeColumns(columns, &results);
+
+  ASSERT_EQ(599u, results.size());
+  EXPECT_NE(results[0], results[0]);
+  EXPECT_EQ(0, results[1]);
+  EXPECT_EQ(1194, results[598]);
+}
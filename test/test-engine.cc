@@ -1,6 +1,10 @@
 #include <gtest/gtest.h>
 #include <bastian.h>
 
+#include <string>
+#include <thread>
+#include <vector>
+
 #ifdef BASTIAN_V8
 #define ENGINE_TEST_SUITE V8Engine
 #endif
@@ -78,3 +82,466 @@ TEST(ENGINE_TEST_SUITE, PreconstructedObject) {
   EXPECT_STREQ("object", local_result->StringValue().c_str());
 }
 
+
+static int generator_calls = 0;
+
+BASTIAN_OBJECT(CountedGlobal) (bastian::ObjectRef obj) {
+  generator_calls++;
+  obj->Export("collect", CollectEngineResult);
+}
+
+TEST(ENGINE_TEST_SUITE, ReuseGlobalTemplate) {
+  generator_calls = 0;
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(CountedGlobal);
+  engine->Run("collect(1)");
+  engine->Run("collect(2)");
+  EXPECT_EQ(2, result->NumberValue());
+
+  engine->Rebuild();
+  engine->Run("collect(3)");
+  EXPECT_EQ(3, result->NumberValue());
+
+#ifdef BASTIAN_V8
+  EXPECT_EQ(2, generator_calls);
+#endif
+}
+
+TEST(ENGINE_TEST_SUITE, ScriptCacheHits) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(Global);
+  engine->Run("collect(1)");
+  engine->Run("collect(1)");
+  engine->Run("collect(2)");
+
+  bastian::script_cache_stats stats = engine->ScriptCacheStats();
+  EXPECT_EQ(1u, stats.hits);
+  EXPECT_EQ(2u, stats.misses);
+  EXPECT_EQ(2u, stats.entries);
+}
+
+TEST(ENGINE_TEST_SUITE, ScriptCacheEviction) {
+  bastian::EngineOptions options;
+  options.script_cache_bytes = 16;
+
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(Global, options);
+  engine->Run("collect(10)");
+  engine->Run("collect(20)");
+  engine->Run("collect(10)");
+  EXPECT_EQ(10, result->NumberValue());
+
+  bastian::script_cache_stats stats = engine->ScriptCacheStats();
+  EXPECT_EQ(0u, stats.hits);
+  EXPECT_EQ(1u, stats.entries);
+  EXPECT_EQ(2u, stats.evictions);
+
+  // Clearing the cache is not an eviction.
+  engine->Dispose();
+  stats = engine->ScriptCacheStats();
+  EXPECT_EQ(0u, stats.entries);
+  EXPECT_EQ(2u, stats.evictions);
+}
+
+TEST(ENGINE_TEST_SUITE, CompiledScriptRunsInFreshContexts) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(Global);
+  bastian::Handle<bastian::Script> script = engine->Compile(
+    "var runs = (typeof runs === 'undefined' ? 0 : runs) + 1; collect(runs)");
+
+  EXPECT_TRUE(script->IsValid());
+
+  for (int run = 0; run < 3; ++run) {
+    engine->Run(script);
+    EXPECT_EQ(1, result->NumberValue());
+  }
+
+  EXPECT_EQ(1u, engine->ScriptCacheStats().misses);
+}
+
+TEST(ENGINE_TEST_SUITE, CompileWithName) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(Global);
+  engine->Compile("collect(1)", "first.js");
+  engine->Compile("collect(1)", "second.js");
+  engine->Compile("collect(1)", "first.js");
+
+  bastian::script_cache_stats stats = engine->ScriptCacheStats();
+  EXPECT_EQ(1u, stats.hits);
+  EXPECT_EQ(2u, stats.entries);
+}
+
+TEST(ENGINE_TEST_SUITE, CompileError) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(Global);
+  bastian::Handle<bastian::Script> script = engine->Compile("collect(");
+
+  EXPECT_FALSE(script->IsValid());
+  EXPECT_TRUE(engine->Run(script)->IsNull());
+
+  engine->Compile("collect(");
+  EXPECT_EQ(1u, engine->ScriptCacheStats().hits);
+}
+
+TEST(ENGINE_TEST_SUITE, RunWithArguments) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(Global);
+  bastian::Handle<bastian::Script> script = engine->Compile(
+    "return arguments[0] + foobar * arguments[1];", "params.js");
+
+  for (int run = 0; run < 3; ++run) {
+    std::vector<bastian::Handle<bastian::Value>> arguments;
+    arguments.push_back(bastian::Number::New(run));
+    arguments.push_back(bastian::Number::New(2));
+
+    EXPECT_EQ(run + 84, engine->Run(script, arguments)->NumberValue());
+  }
+
+  // The plain script and the function body are the only compilations.
+  EXPECT_EQ(2u, engine->ScriptCacheStats().misses);
+}
+
+TEST(ENGINE_TEST_SUITE, BodyClosingFunction) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(Global);
+  bastian::Handle<bastian::Script> script = engine->Compile(
+    "}); collect(1); (function () {");
+  std::vector<bastian::Handle<bastian::Value>> arguments;
+
+  result = bastian::NullValue::New();
+
+  EXPECT_TRUE(engine->Run(script, arguments)->IsNull());
+  EXPECT_TRUE(engine->Run(script, arguments)->IsNull());
+  EXPECT_TRUE(result->IsNull());
+}
+
+TEST(ENGINE_TEST_SUITE, BodyErrorLine) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(Global);
+  bastian::Handle<bastian::Script> script = engine->Compile(
+    "\nreturn new Error().stack;", "body.js");
+  std::vector<bastian::Handle<bastian::Value>> arguments;
+  std::string stack = engine->Run(script, arguments)->StringValue();
+
+#ifdef BASTIAN_V8
+  EXPECT_NE(std::string::npos, stack.find("body.js:2:"));
+#endif
+}
+
+TEST(ENGINE_TEST_SUITE, RunWithStringArgument) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(Global);
+  bastian::Handle<bastian::Script> script = engine->Compile(
+    "return 'hello ' + arguments[0];");
+  std::vector<bastian::Handle<bastian::Value>> arguments;
+  arguments.push_back(bastian::String::New("bastian"));
+
+  EXPECT_STREQ("hello bastian",
+    engine->Run(script, arguments)->StringValue().c_str());
+}
+
+TEST(ENGINE_TEST_SUITE, FillContextPool) {
+  bastian::EngineOptions options;
+  options.context_pool_size = 2;
+  bastian::Handle<bastian::Engine> engine =
+    bastian::Engine::New(Global, options);
+
+  EXPECT_TRUE(engine->FillContextPool());
+  EXPECT_TRUE(engine->FillContextPool());
+  EXPECT_FALSE(engine->FillContextPool());
+
+  engine->Run("var forcingGlobal = 42");
+  engine->Run("util.collect(typeof forcingGlobal === 'undefined' ? 0 : forcingGlobal)");
+  EXPECT_EQ(0, result->NumberValue());
+  EXPECT_TRUE(engine->FillContextPool());
+}
+
+TEST(ENGINE_TEST_SUITE, ResetPooledContext) {
+  bastian::EngineOptions options;
+  options.context_pool_size = 1;
+  options.context_policy = bastian::EngineOptions::CONTEXT_RESET;
+  bastian::Handle<bastian::Engine> engine =
+    bastian::Engine::New(Global, options);
+
+  for (int run = 0; run < 3; ++run) {
+    engine->Run("var forcingGlobal = 42; implicitGlobal = 42");
+    engine->Run("foobar = 0; collect = null; delete Math; JSON = 1");
+    EXPECT_STREQ("function object object", engine->Run(
+      "[typeof collect, typeof Math, typeof JSON].join(' ')")
+      ->StringValue().c_str());
+    engine->Run("util.collect(typeof forcingGlobal === 'undefined' ? 0 : forcingGlobal)");
+    EXPECT_EQ(0, result->NumberValue());
+    engine->Run("util.collect(typeof implicitGlobal === 'undefined' ? 0 : implicitGlobal)");
+    EXPECT_EQ(0, result->NumberValue());
+    EXPECT_EQ(42, engine->Run("foobar")->NumberValue());
+  }
+}
+
+// Unlike Global, builds nothing that outlives an isolate.
+BASTIAN_OBJECT(ThreadGlobal) (bastian::ObjectRef obj) {
+  obj->Export("collect", CollectEngineResult);
+  obj->Export("foobar", bastian::Number::New(42));
+}
+
+TEST(ENGINE_TEST_SUITE, DisposeOnFreshThread) {
+  std::thread thread([] {
+    // The second round runs in a new isolate, the first one is disposed
+    // with the last engine using it.
+    for (int run = 0; run < 2; ++run) {
+      bastian::Handle<bastian::Engine> engine = bastian::Engine::New(ThreadGlobal);
+      bastian::Handle<bastian::Engine> other = bastian::Engine::New(ThreadGlobal);
+
+      EXPECT_EQ(42, engine->Run("foobar")->NumberValue());
+      engine.Clear();
+      EXPECT_EQ(84, other->Run("foobar * 2")->NumberValue());
+      other->Dispose();
+      other.Clear();
+    }
+  });
+
+  thread.join();
+}
+
+TEST(ENGINE_TEST_SUITE, ValuesOutliveEngine) {
+  std::thread thread([] {
+    bastian::Handle<bastian::Engine> engine = bastian::Engine::New(ThreadGlobal);
+    bastian::Handle<bastian::Script> script = engine->Compile("foobar");
+    bastian::Handle<bastian::Value> object = engine->Run(
+      "({ list: [1], name: 'x', call: function () {} })");
+    bastian::Handle<bastian::Value> list = bastian::Object::Cast(object)->Get("list");
+
+    EXPECT_EQ(42, engine->Run(script)->NumberValue());
+
+    // The last engine of the thread disposes the isolate.
+    engine->Dispose();
+    engine.Clear();
+    list.Clear();
+    object.Clear();
+    script.Clear();
+  });
+
+  thread.join();
+}
+
+TEST(ENGINE_TEST_SUITE, KeptStringArgument) {
+  std::thread thread([] {
+    bastian::Handle<bastian::Engine> engine = bastian::Engine::New(ThreadGlobal);
+
+    engine->Run("collect('kept ' + foobar)");
+    engine->Dispose();
+  });
+
+  thread.join();
+  EXPECT_STREQ("kept 42", result->StringValue().c_str());
+  result = bastian::NullValue::New();
+}
+
+#ifdef BASTIAN_V8
+TEST(ENGINE_TEST_SUITE, PreludeFromSnapshot) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(Global);
+  EXPECT_EQ(84, engine->Run("prelude.double(foobar)")->NumberValue());
+}
+#endif
+
+static int external_releases = 0;
+
+static void ReleaseExternal(void* user_data) {
+  ++external_releases;
+}
+
+TEST(ENGINE_TEST_SUITE, ExternalStringArgument) {
+  static const char document[] = "external document";
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(Global);
+  bastian::Handle<bastian::Script> script = engine->Compile(
+    "return arguments[0].length + ':' + arguments[0].slice(0, 8);");
+
+  {
+    std::vector<bastian::Handle<bastian::Value>> arguments;
+    arguments.push_back(bastian::String::NewExternal(
+      document, sizeof(document) - 1, ReleaseExternal, NULL));
+
+    EXPECT_STREQ("17:external",
+      engine->Run(script, arguments)->StringValue().c_str());
+    EXPECT_EQ(document, arguments.at(0)->StringView().data);
+  }
+
+  engine.Clear();
+#ifdef BASTIAN_V8
+  v8::Isolate::GetCurrent()->LowMemoryNotification();
+#endif
+  EXPECT_EQ(1, external_releases);
+}
+
+TEST(ENGINE_TEST_SUITE, SharedTypedArray) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(Global);
+  bastian::Handle<bastian::Value> samples = bastian::Float64Array::New(1000);
+  double* data = bastian::Float64Array::Cast(samples)->Data();
+
+  for (int index = 0; index < 1000; ++index) {
+    data[index] = index;
+  }
+
+  std::vector<bastian::Handle<bastian::Value>> arguments;
+  arguments.push_back(samples);
+
+  EXPECT_EQ(499500, engine->Run(engine->Compile(
+    "var samples = arguments[0], sum = 0;"
+    "for (var i = 0; i < samples.length; ++i) {"
+    "  sum += samples[i];"
+    "  samples[i] *= 2;"
+    "}"
+    "return sum;"), arguments)->NumberValue());
+  EXPECT_EQ(1998, data[999]);
+}
+
+TEST(ENGINE_TEST_SUITE, ScriptArrayBuffer) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(Global);
+  bastian::Handle<bastian::Value> ints = engine->Run(
+    "var ints = new Int32Array(new ArrayBuffer(16), 4, 2);"
+    "ints[1] = 42;"
+    "ints");
+  bastian::Int32Array* array = bastian::Int32Array::Cast(ints);
+
+  ASSERT_TRUE(array != NULL);
+  EXPECT_EQ(2u, array->Length());
+  EXPECT_EQ(4u, array->ByteOffset());
+  EXPECT_EQ(16u, array->Buffer()->Length());
+  EXPECT_EQ(42, array->Data()[1]);
+
+  array->Data()[0] = 5;
+
+  std::vector<bastian::Handle<bastian::Value>> arguments;
+  arguments.push_back(ints);
+  arguments.push_back(bastian::ArrayBuffer::New(array->Buffer()));
+
+  EXPECT_EQ(52, engine->Run(engine->Compile(
+    "return arguments[0][0] + arguments[0][1] +"
+    "  new Int32Array(arguments[1])[1];"), arguments)->NumberValue());
+}
+
+TEST(ENGINE_TEST_SUITE, ExternalArrayBufferRelease) {
+  static double samples[4] = { 1, 2, 3, 4 };
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(Global);
+
+  external_releases = 0;
+
+  {
+    std::vector<bastian::Handle<bastian::Value>> arguments;
+    arguments.push_back(bastian::Float64Array::New(
+      bastian::ExternalBuffer::New(
+        samples, sizeof(samples), ReleaseExternal, NULL),
+      8, 2));
+
+    EXPECT_EQ(5, engine->Run(engine->Compile(
+      "return arguments[0][0] + arguments[0][1];"), arguments)->NumberValue());
+  }
+
+  engine.Clear();
+#ifdef BASTIAN_V8
+  v8::Isolate::GetCurrent()->LowMemoryNotification();
+#endif
+  EXPECT_EQ(1, external_releases);
+}
+
+TEST(ENGINE_TEST_SUITE, VectorArguments) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(Global);
+  std::vector<double> samples;
+
+  for (int index = 0; index < 100; ++index) {
+    samples.push_back(index * 0.5);
+  }
+
+  std::vector<bastian::Handle<bastian::Value>> arguments;
+  arguments.push_back(bastian::Value::FromVector(samples));
+
+  bastian::Handle<bastian::Value> sums = engine->Run(engine->Compile(
+    "var samples = arguments[0], sums = [0, 0];"
+    "for (var i = 0; i < samples.length; ++i) {"
+    "  sums[i % 2] += samples[i];"
+    "}"
+    "return sums;"), arguments);
+  std::vector<double> values;
+
+  ASSERT_TRUE(sums->IsArray());
+  ASSERT_TRUE(sums->ToVector(&values));
+  ASSERT_EQ(2u, values.size());
+  EXPECT_EQ(1225, values[0]);
+  EXPECT_EQ(1250, values[1]);
+  EXPECT_EQ(1250, bastian::Array::Cast(sums)->Get(1)->NumberValue());
+  EXPECT_TRUE(bastian::Array::Cast(sums)->Get(2)->IsUndefined());
+}
+
+TEST(ENGINE_TEST_SUITE, SparseArrayToVector) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(Global);
+  std::vector<double> values;
+
+  ASSERT_TRUE(engine->Run("var a = [1, 'two']; a[3] = 4; a")->ToVector(&values));
+  ASSERT_EQ(4u, values.size());
+  EXPECT_EQ(1, values[0]);
+  EXPECT_NE(values[1], values[1]);
+  EXPECT_NE(values[2], values[2]);
+  EXPECT_EQ(4, values[3]);
+  EXPECT_FALSE(engine->Run("'1,2'")->ToVector(&values));
+}
+
+TEST(ENGINE_TEST_SUITE, HostArray) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(Global);
+  std::vector<bastian::Handle<bastian::Value>> elements;
+  elements.push_back(bastian::Number::New(1));
+  elements.push_back(bastian::String::New("two"));
+
+  std::vector<bastian::Handle<bastian::Value>> arguments;
+  arguments.push_back(bastian::Array::New(elements));
+
+  EXPECT_STREQ("true:1,two", engine->Run(engine->Compile(
+    "return Array.isArray(arguments[0]) + ':' + arguments[0].join();"),
+    arguments)->StringValue().c_str());
+}
+
+TEST(ENGINE_TEST_SUITE, ScriptObjectResult) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(Global);
+  bastian::Handle<bastian::Value> config = engine->Run(
+    "({ name: 'sensor', rate: 50, nested: { unit: 'ms' } })");
+  bastian::Object* object = bastian::Object::Cast(config);
+
+  ASSERT_TRUE(object != NULL);
+  ASSERT_EQ(3u, object->Keys().size());
+  EXPECT_STREQ("nested", object->Keys().at(2).c_str());
+  EXPECT_EQ(50, object->Get("rate")->NumberValue());
+  EXPECT_TRUE(object->Get("missing")->IsUndefined());
+
+  bastian::Handle<bastian::Value> nested = object->Get("nested");
+
+  EXPECT_TRUE(bastian::Handle<bastian::Value>::Is(
+    nested.operator->(), object->Get("nested")));
+  EXPECT_STREQ("ms",
+    bastian::Object::Cast(nested)->Get("unit")->StringValue().c_str());
+  EXPECT_TRUE(bastian::Object::Cast(bastian::Number::New(1)) == NULL);
+
+  std::vector<bastian::Handle<bastian::Value>> arguments;
+  arguments.push_back(nested);
+
+  EXPECT_STREQ("ms", engine->Run(engine->Compile(
+    "return arguments[0].unit;"), arguments)->StringValue().c_str());
+}
+
+TEST(ENGINE_TEST_SUITE, ThrowingReads) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(Global);
+  bastian::Handle<bastian::Value> config = engine->Run(
+    "var failing = { get: function () { throw new Error('read'); } };"
+    "var values = [1, 2];"
+    "Object.defineProperty(values, 1, failing);"
+    "Object.defineProperty({ rate: 50, values: values }, 'unit', failing)");
+  bastian::Object* object = bastian::Object::Cast(config);
+  std::vector<double> numbers;
+
+  ASSERT_TRUE(object != NULL);
+  EXPECT_TRUE(object->Get("unit")->IsUndefined());
+  EXPECT_EQ(50, object->Get("rate")->NumberValue());
+  EXPECT_TRUE(bastian::Array::Cast(object->Get("values"))
+    ->Get(1)->IsUndefined());
+  EXPECT_TRUE(object->Get("values")->ToVector(&numbers));
+  ASSERT_EQ(2u, numbers.size());
+  EXPECT_EQ(1, numbers[0]);
+  EXPECT_NE(numbers[1], numbers[1]);
+  EXPECT_STREQ("{\"rate\":50,\"values\":[1,null]}", config->ToJSON().c_str());
+}
+
+TEST(ENGINE_TEST_SUITE, ExternalOwnedString) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(Global);
+  std::vector<bastian::Handle<bastian::Value>> arguments;
+  arguments.push_back(bastian::String::NewExternal(std::string("h\xc3\xa9llo")));
+
+  EXPECT_EQ(5, engine->Run(
+    engine->Compile("return arguments[0].length;"), arguments)->NumberValue());
+}
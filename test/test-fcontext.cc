@@ -77,3 +77,77 @@ TEST(FUNCTION_CONTEXT_TEST_SUITE, Concat) {
   testContext.RunJS("collectResult(concat('foo', 'bar'))");
   EXPECT_STREQ("foobar", result->StringValue().c_str());
 }
+
+static double numberArgument = 0;
+static double missingNumber = 0;
+static int32_t int32Argument = 0;
+static std::string stringArgument;
+static std::string missingArgument;
+
+BASTIAN_FUNCTION(ReadTyped) (bastian::FunctionRef func) {
+  bastian::string_view view = func->GetStringView(2);
+  bastian::string_view missing = func->GetStringView(5);
+
+  numberArgument = func->GetNumber(0);
+  missingNumber = func->GetNumber(5);
+  int32Argument = func->GetInt32(1) + func->GetInt32(5);
+  stringArgument.assign(view.data, view.length);
+  missingArgument.assign(missing.data, missing.length);
+}
+
+TEST(FUNCTION_CONTEXT_TEST_SUITE, TypedArguments) {
+  TestContext testContext;
+  testContext.AddFunction("readTyped", ReadTyped);
+  testContext.RunJS("readTyped(2.5, 4294967297, 'h\\u00e9llo')");
+  EXPECT_EQ(2.5, numberArgument);
+  EXPECT_TRUE(missingNumber != missingNumber);
+  EXPECT_EQ(1, int32Argument);
+  EXPECT_STREQ("h\xc3\xa9llo", stringArgument.c_str());
+  EXPECT_STREQ("undefined", missingArgument.c_str());
+
+  testContext.RunJS("readTyped('7', '-1.9', 42)");
+  EXPECT_EQ(7, numberArgument);
+  EXPECT_EQ(-1, int32Argument);
+  EXPECT_STREQ("42", stringArgument.c_str());
+}
+
+BASTIAN_FUNCTION(ReadView) (bastian::FunctionRef func) {
+  bastian::string_view view = func->GetStringView(0);
+
+  stringArgument.assign(view.data, view.length);
+}
+
+TEST(FUNCTION_CONTEXT_TEST_SUITE, ThrowingStringArgument) {
+  TestContext testContext;
+  testContext.AddFunction("readView", ReadView);
+  testContext.AddFunction("collectResult", CollectFContextResult);
+  testContext.RunJS(
+    "try { readView({ toString: function () { throw 1; } }); }"
+    "catch (error) { collectResult('caught ' + error); }");
+  EXPECT_STREQ("", stringArgument.c_str());
+  EXPECT_STREQ("caught 1", result->StringValue().c_str());
+}
+
+static bool sameView = false;
+static bool sameArgument = false;
+
+BASTIAN_FUNCTION(ReadTwice) (bastian::FunctionRef func) {
+  bastian::string_view first = func->GetStringView(0);
+  bastian::string_view second = func->GetStringView(0);
+  bastian::Handle<bastian::Value> argument = func->GetArgument(1);
+  bastian::Handle<bastian::Value> again = func->GetArgument(1);
+
+  sameView = first.data == second.data && first.length == second.length;
+  sameArgument = argument->StringView().data == again->StringView().data;
+  func->SetResult(bastian::Number::New(func->GetNumber(1)));
+}
+
+TEST(FUNCTION_CONTEXT_TEST_SUITE, MemoizedArguments) {
+  TestContext testContext;
+  testContext.AddFunction("readTwice", ReadTwice);
+  testContext.AddFunction("collectResult", CollectFContextResult);
+  testContext.RunJS("collectResult(readTwice({}, '12'))");
+  EXPECT_TRUE(sameView);
+  EXPECT_TRUE(sameArgument);
+  EXPECT_EQ(12, result->NumberValue());
+}
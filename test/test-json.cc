@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+#include <bastian.h>
+
+#include <clocale>
+#include <cstring>
+#include <string>
+
+#ifdef BASTIAN_V8
+#define JSON_TEST_SUITE V8JSON
+#endif
+
+#ifdef BASTIAN_JSC
+#define JSON_TEST_SUITE JSCJSON
+#endif
+
+
+BASTIAN_OBJECT(JSONGlobal) (bastian::ObjectRef obj) {
+  obj->Export("answer", bastian::Number::New(42));
+}
+
+static bastian::Handle<bastian::Value> Parse(const char * json) {
+  return bastian::Value::FromJSON(json, std::strlen(json));
+}
+
+TEST(JSON_TEST_SUITE, ScanString) {
+  std::string text(40, 'a');
+
+  EXPECT_EQ(text.data() + 40,
+    bastian::ScanJSONString(text.data(), text.data() + 40));
+
+  text[33] = '\\';
+  text[37] = '"';
+  EXPECT_EQ(text.data() + 33,
+    bastian::ScanJSONString(text.data(), text.data() + 40));
+  EXPECT_EQ(text.data() + 37,
+    bastian::ScanJSONString(text.data() + 34, text.data() + 40));
+
+  text[17] = '\n';
+  text[5] = '\xc3';
+  EXPECT_EQ(text.data() + 17,
+    bastian::ScanJSONString(text.data(), text.data() + 40));
+}
+
+TEST(JSON_TEST_SUITE, ParseScalars) {
+  EXPECT_EQ(-1250, Parse(" -1.25e3 ")->NumberValue());
+  EXPECT_TRUE(Parse("true")->BooleanValue());
+  EXPECT_TRUE(Parse("null")->IsNull());
+  EXPECT_STREQ("a\"b\\c\n\xc3\xa9\xf0\x9f\x98\x80",
+    Parse("\"a\\\"b\\\\c\\n\\u00e9\\ud83d\\ude00\"")->StringValue().c_str());
+}
+
+TEST(JSON_TEST_SUITE, ParseNested) {
+  bastian::Handle<bastian::Value> value = Parse(
+    "{\"id\": 7, \"tags\": [\"a\", {\"b\": null}], \"id\": 8, \"ok\": false}");
+  bastian::Object* object = bastian::Object::Cast(value);
+
+  ASSERT_TRUE(object != NULL);
+  ASSERT_EQ(3u, object->Keys().size());
+  EXPECT_STREQ("tags", object->Keys().at(1).c_str());
+  EXPECT_EQ(8, object->Get("id")->NumberValue());
+  EXPECT_TRUE(object->Get("missing")->IsUndefined());
+
+  bastian::Array* tags = bastian::Array::Cast(object->Get("tags"));
+
+  ASSERT_TRUE(tags != NULL);
+  EXPECT_EQ(2u, tags->Length());
+  EXPECT_TRUE(bastian::Object::Cast(tags->Get(1))->Get("b")->IsNull());
+}
+
+TEST(JSON_TEST_SUITE, RejectInvalid) {
+  EXPECT_TRUE(Parse("")->IsUndefined());
+  EXPECT_TRUE(Parse("{\"a\" 1}")->IsUndefined());
+  EXPECT_TRUE(Parse("[1, 2,]")->IsUndefined());
+  EXPECT_TRUE(Parse("01")->IsUndefined());
+  EXPECT_TRUE(Parse("\"tab\there\"")->IsUndefined());
+  EXPECT_TRUE(Parse("[1] 2")->IsUndefined());
+  EXPECT_TRUE(Parse(std::string(1000, '[').c_str())->IsUndefined());
+}
+
+TEST(JSON_TEST_SUITE, WriteHostValues) {
+  const char * json =
+    "{\"name\":\"line\\n\\\"two\\\"\\u0001\",\"list\":[1,0.1,-2.5e-7,true,null]"
+    ",\"empty\":{}}";
+
+  EXPECT_STREQ(json, Parse(json)->ToJSON().c_str());
+  EXPECT_STREQ("[1e+21,123456789012,0.000001,1e-7,-0.30000000000000004]",
+    Parse("[1e21, 123456789012, 1e-6, 1e-7, -0.30000000000000004]")
+      ->ToJSON().c_str());
+  EXPECT_STREQ("", bastian::UndefinedValue::New()->ToJSON().c_str());
+
+  std::vector<double> samples;
+  samples.push_back(0.5);
+  samples.push_back(3);
+
+  EXPECT_STREQ("[0.5,3]", bastian::Value::FromVector(samples)->ToJSON().c_str());
+}
+
+TEST(JSON_TEST_SUITE, ScriptValues) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(JSONGlobal);
+  bastian::Handle<bastian::Value> result = engine->Run(
+    "({ answer: answer, skipped: function () {}, nested: [undefined, 'x'] })");
+
+  EXPECT_STREQ("{\"answer\":42,\"nested\":[null,\"x\"]}",
+    result->ToJSON().c_str());
+  EXPECT_STREQ("", engine->Run("var o = {}; o.self = o; o")->ToJSON().c_str());
+
+  std::vector<bastian::Handle<bastian::Value>> arguments;
+  arguments.push_back(Parse("{\"a\": [1, 2, {\"b\": \"c\"}]}"));
+
+  EXPECT_STREQ("{\"a\":[1,2,{\"b\":\"c\"}]}", engine->Run(engine->Compile(
+    "return JSON.stringify(arguments[0]);"), arguments)->StringValue().c_str());
+}
+
+TEST(JSON_TEST_SUITE, ScriptToJSON) {
+  bastian::Handle<bastian::Engine> engine = bastian::Engine::New(JSONGlobal);
+  bastian::Handle<bastian::Value> result = engine->Run(
+    "({ date: new Date(0), number: new Number(1.5), string: new String('ab'),"
+    " flag: new Boolean(false), keyed: [{ toJSON: function (key) {"
+    " return { key: key, toJSON: function () { return 0; } }; } }] })");
+
+  EXPECT_STREQ(
+    "{\"date\":\"1970-01-01T00:00:00.000Z\",\"number\":1.5,\"string\":\"ab\","
+    "\"flag\":false,\"keyed\":[{\"key\":\"0\"}]}",
+    result->ToJSON().c_str());
+  EXPECT_STREQ("", engine->Run(
+    "({ toJSON: function () { throw new Error(); } })")->ToJSON().c_str());
+  EXPECT_STREQ("", engine->Run(
+    "({ a: 1, b: [{ toJSON: function () { throw new Error(); } }] })")
+    ->ToJSON().c_str());
+  EXPECT_STREQ("", engine->Run(
+    "({ a: { get b() { throw new Error(); } } })")->ToJSON().c_str());
+}
+
+TEST(JSON_TEST_SUITE, DecimalCommaLocale) {
+  const char * locales[] = { "de_DE.UTF-8", "fr_FR.UTF-8", "ru_RU.UTF-8" };
+  bool set = false;
+
+  for (size_t index = 0; index < 3 && !set; ++index) {
+    set = std::setlocale(LC_NUMERIC, locales[index]) != NULL;
+  }
+
+  // Nothing to test without a locale writing numbers with a comma.
+  if (!set) {
+    return;
+  }
+
+  EXPECT_EQ(1.25, Parse("1.25")->NumberValue());
+  EXPECT_STREQ("[0.1,-2.5e-7]", Parse("[0.1, -2.5e-7]")->ToJSON().c_str());
+  std::setlocale(LC_NUMERIC, "C");
+}
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include <bastian.h>
+
+#include <atomic>
+#include <vector>
+
+#ifdef BASTIAN_V8
+#define PLATFORM_TEST_SUITE V8Platform
+#endif
+
+#ifdef BASTIAN_JSC
+#define PLATFORM_TEST_SUITE JSCPlatform
+#endif
+
+
+TEST(PLATFORM_TEST_SUITE, InitOnce) {
+  EXPECT_FALSE(bastian::Init());
+}
+
+#ifdef BASTIAN_V8
+class CountingTask : public v8::Task {
+ public:
+  explicit CountingTask(std::atomic<int>* runs) : runs_(runs) {}
+
+  void Run() {
+    ++*runs_;
+  }
+
+ private:
+  std::atomic<int>* runs_;
+};
+
+TEST(PLATFORM_TEST_SUITE, BackgroundTasks) {
+  std::atomic<int> runs(0);
+  std::vector<int> cpu_affinity(1, 0);
+
+  {
+    bastian::WorkerPlatform platform(3, cpu_affinity);
+    EXPECT_EQ(3, platform.WorkerThreads());
+
+    for (int index = 0; index < 10; ++index) {
+      platform.CallOnBackgroundThread(
+        new CountingTask(&runs), v8::Platform::kShortRunningTask);
+    }
+  }
+
+  EXPECT_EQ(10, runs);
+}
+
+TEST(PLATFORM_TEST_SUITE, ForegroundTasks) {
+  std::atomic<int> runs(0);
+  bastian::WorkerPlatform platform(1, std::vector<int>());
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+
+  platform.CallOnForegroundThread(isolate, new CountingTask(&runs));
+  platform.CallOnForegroundThread(isolate, new CountingTask(&runs));
+
+  EXPECT_EQ(0, runs);
+  EXPECT_TRUE(platform.PumpMessageLoop(isolate));
+  EXPECT_TRUE(platform.PumpMessageLoop(isolate));
+  EXPECT_FALSE(platform.PumpMessageLoop(isolate));
+  EXPECT_EQ(2, runs);
+}
+
+TEST(PLATFORM_TEST_SUITE, TaskWaker) {
+  std::atomic<int> runs(0);
+  int wakes = 0;
+  bastian::WorkerPlatform platform(1, std::vector<int>());
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+
+  platform.SetTaskWaker(isolate, [&wakes] { ++wakes; });
+  platform.CallOnForegroundThread(isolate, new CountingTask(&runs));
+  EXPECT_EQ(1, wakes);
+
+  platform.SetTaskWaker(isolate, std::function<void()>());
+  platform.CallOnForegroundThread(isolate, new CountingTask(&runs));
+  EXPECT_EQ(1, wakes);
+
+  while (platform.PumpMessageLoop(isolate)) {}
+  EXPECT_EQ(2, runs);
+}
+#endif
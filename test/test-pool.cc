@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include <bastian.h>
+
+#include <thread>
+#include <vector>
+
+#ifdef BASTIAN_V8
+#define POOL_TEST_SUITE V8EnginePool
+#endif
+
+#ifdef BASTIAN_JSC
+#define POOL_TEST_SUITE JSCEnginePool
+#endif
+
+
+BASTIAN_FUNCTION(PoolDouble) (bastian::FunctionRef func) {
+  double val = func->GetArgument(0)->NumberValue();
+  func->SetResult(bastian::Number::New(val * 2));
+}
+
+BASTIAN_OBJECT(PoolGlobal) (bastian::ObjectRef obj) {
+  obj->Export("double", PoolDouble);
+  obj->Export("foobar", bastian::Number::New(42));
+}
+
+TEST(POOL_TEST_SUITE, Size) {
+  bastian::Handle<bastian::EnginePool> pool = bastian::EnginePool::New(PoolGlobal, 3);
+  EXPECT_EQ(3, pool->Size());
+}
+
+TEST(POOL_TEST_SUITE, RunResult) {
+  bastian::Handle<bastian::EnginePool> pool = bastian::EnginePool::New(PoolGlobal, 2);
+  EXPECT_EQ(42, pool->Run("foobar")->NumberValue());
+  EXPECT_EQ(84, pool->Run("double(foobar)")->NumberValue());
+}
+
+#ifdef BASTIAN_V8
+TEST(POOL_TEST_SUITE, PooledContexts) {
+  bastian::EngineOptions options;
+  options.context_pool_size = 1;
+  options.context_policy = bastian::EngineOptions::CONTEXT_RESET;
+  bastian::Handle<bastian::EnginePool> pool =
+    bastian::EnginePool::New(PoolGlobal, options, 1);
+
+  // Changes made inside built-in objects survive in a reset context.
+  pool->Run("Array.prototype.pooled = 7");
+  EXPECT_EQ(7, pool->Run("[].pooled")->NumberValue());
+}
+#endif
+
+TEST(POOL_TEST_SUITE, ConcurrentCallers) {
+  bastian::Handle<bastian::EnginePool> pool = bastian::EnginePool::New(PoolGlobal, 2);
+  std::vector<std::thread> callers;
+  std::vector<double> results(8);
+
+  for (unsigned index = 0; index < results.size(); ++index) {
+    callers.push_back(std::thread([&pool, &results, index] {
+      results[index] = pool->Run("double(21)")->NumberValue();
+    }));
+  }
+
+  for (unsigned index = 0; index < callers.size(); ++index) {
+    callers.at(index).join();
+  }
+
+  for (unsigned index = 0; index < results.size(); ++index) {
+    EXPECT_EQ(42, results.at(index));
+  }
+}
+
+TEST(POOL_TEST_SUITE, ResultsDroppedByCallers) {
+  bastian::Handle<bastian::EnginePool> pool = bastian::EnginePool::New(PoolGlobal, 1);
+
+  for (int run = 0; run < 100; ++run) {
+    pool->Run("({ call: function () {} })");
+  }
+
+  EXPECT_EQ(42, pool->Run("foobar")->NumberValue());
+
+  bastian::Handle<bastian::Value> kept = pool->Run("(function () {})");
+
+  pool.Clear();
+  EXPECT_TRUE(kept->IsFunction());
+}
+
+TEST(POOL_TEST_SUITE, PerThreadRunContext) {
+  bastian::Engine::New(PoolGlobal)->Run("foobar");
+  EXPECT_FALSE(bastian::Handle<bastian::RunContext>::Is(
+    NULL, bastian::RunContext::GetCurrent()));
+
+  bool empty_on_other_thread = false;
+  std::thread other([&empty_on_other_thread] {
+    empty_on_other_thread = bastian::Handle<bastian::RunContext>::Is(
+      NULL, bastian::RunContext::GetCurrent());
+  });
+  other.join();
+
+  EXPECT_TRUE(empty_on_other_thread);
+}
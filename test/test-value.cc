@@ -1,6 +1,9 @@
 #include <gtest/gtest.h>
 #include <bastian.h>
 
+#include <string>
+#include <utility>
+
 
 #ifdef BASTIAN_V8
 #include "v8/test-v8-common.h"
@@ -58,4 +61,80 @@ TEST(VALUE_TEST_SUITE, CallFunctionOnceWithArg) {
 
   result->Call(arguments);
   EXPECT_EQ(42, result2->NumberValue());
-}
\ No newline at end of file
+}
+
+TEST(VALUE_TEST_SUITE, RecognizePrimitives) {
+  TestContext testContext;
+  testContext.AddFunction("collect", CollectValueResult);
+  testContext.AddFunction("collect2", CollectValueResult2);
+  testContext.RunJS("collect(true); collect2(undefined)");
+
+  EXPECT_TRUE(result->IsBoolean());
+  EXPECT_TRUE(result->BooleanValue());
+  EXPECT_TRUE(result2->IsUndefined());
+}
+
+TEST(VALUE_TEST_SUITE, PrimitiveHandleCopies) {
+  bastian::Handle<bastian::Value> number = bastian::Number::New(42);
+  bastian::Handle<bastian::Value> copy = number;
+  bastian::Handle<bastian::Value> moved(std::move(number));
+
+  number = bastian::String::New("foobar");
+  copy = copy;
+
+  EXPECT_EQ(42, copy->NumberValue());
+  EXPECT_EQ(42, moved->NumberValue());
+  EXPECT_STREQ("foobar", number->StringValue().c_str());
+
+  moved = number;
+  number = bastian::Boolean::New(true);
+
+  EXPECT_STREQ("foobar", moved->StringValue().c_str());
+  EXPECT_TRUE(number->BooleanValue());
+}
+
+TEST(VALUE_TEST_SUITE, StringArgumentView) {
+  TestContext testContext;
+  testContext.AddFunction("collect", CollectValueResult);
+  testContext.AddFunction("collect2", CollectValueResult2);
+  testContext.RunJS("collect('héllo'); collect2('w' + 'orld')");
+
+  bastian::string_view view = result->StringView();
+  EXPECT_EQ(6u, view.length);
+  EXPECT_EQ(0, std::string(view.data, view.length).compare("h\xc3\xa9llo"));
+  EXPECT_STREQ("world", result2->StringValue().c_str());
+}
+
+TEST(VALUE_TEST_SUITE, HostStringView) {
+  bastian::Handle<bastian::Value> string = bastian::String::New("foobar");
+  bastian::string_view view = string->StringView();
+
+  EXPECT_EQ(6u, view.length);
+  EXPECT_EQ(0, std::string(view.data, view.length).compare("foobar"));
+  EXPECT_EQ(0u, bastian::Number::New(42)->StringView().length);
+}
+
+TEST(VALUE_TEST_SUITE, TypedArrayViews) {
+  bastian::Handle<bastian::Value> buffer = bastian::ArrayBuffer::New(16);
+  bastian::Handle<bastian::ExternalBuffer> bytes =
+    bastian::ArrayBuffer::Cast(buffer)->Buffer();
+  bastian::Handle<bastian::Value> doubles =
+    bastian::Float64Array::New(bytes, 8, 1);
+  bastian::Handle<bastian::Value> ints = bastian::Int32Array::New(bytes, 4, 3);
+
+  EXPECT_TRUE(buffer->IsArrayBuffer());
+  EXPECT_TRUE(doubles->IsTypedArray());
+  EXPECT_EQ(16u, bastian::ArrayBuffer::Cast(buffer)->ByteLength());
+  EXPECT_TRUE(bastian::Int32Array::Cast(doubles) == NULL);
+  EXPECT_TRUE(bastian::ArrayBuffer::Cast(doubles) == NULL);
+
+  bastian::Float64Array::Cast(doubles)->Data()[0] = 1.5;
+  bastian::Int32Array::Cast(ints)->Data()[0] = 7;
+
+  EXPECT_EQ(7, static_cast<int32_t*>(bytes->Bytes())[1]);
+  EXPECT_EQ(1.5, static_cast<double*>(bytes->Bytes())[1]);
+  EXPECT_TRUE(bastian::Float64Array::New(bytes, 4, 1)->IsNull());
+  EXPECT_TRUE(bastian::Uint8Array::New(bytes, 8, 9)->IsNull());
+  EXPECT_EQ(16u, bastian::Uint8Array::New(16)->IsTypedArray() ?
+    bastian::Uint8Array::Cast(bastian::Uint8Array::New(16))->Length() : 0);
+}
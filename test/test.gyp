@@ -18,8 +18,14 @@
         '../../deps/gtest/cbuild/libgtest_main.a',
       ],
       'sources': [
+        './test-arena.cc',
+        './test-bind.cc',
+        './test-callsite.cc',
         './test-engine.cc',
         './test-fcontext.cc',
+        './test-json.cc',
+        './test-platform.cc',
+        './test-pool.cc',
         './test-value.cc',
       ],
       'conditions': [
@@ -35,6 +41,55 @@
         }]
       ]
 
+    },
+    {
+      'target_name': 'bench-bastian',
+      'type': 'executable',
+      'includes': [
+        '../common.gypi',
+      ],
+      'include_dirs': [
+        '../deps/gtest/include',
+        '../include'
+      ],
+      'dependencies': [
+        '../bastian.gyp:bastian'
+      ],
+      'libraries': [
+        '../../deps/gtest/cbuild/libgtest.a',
+        '../../deps/gtest/cbuild/libgtest_main.a',
+      ],
+      'sources': [
+        './bench/bench-engine.cc',
+        './bench/bench-pool.cc',
+      ]
     }
+  ],
+  'conditions': [
+    ['bastian_engine == "v8"', {
+      'targets': [
+        {
+          'target_name': 'test-bastian-code-cache',
+          'type': 'executable',
+          'includes': [
+            '../common.gypi',
+          ],
+          'include_dirs': [
+            '../deps/gtest/include',
+            '../include'
+          ],
+          'dependencies': [
+            '../bastian.gyp:bastian'
+          ],
+          'libraries': [
+            '../../deps/gtest/cbuild/libgtest.a',
+            '../../deps/gtest/cbuild/libgtest_main.a',
+          ],
+          'sources': [
+            './v8/test-code-cache.cc',
+          ]
+        }
+      ]
+    }]
   ]
 }
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include <bastian.h>
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+static bastian::Handle<bastian::Value> result = bastian::NullValue::New();
+
+
+BASTIAN_FUNCTION(CollectCodeCacheResult) (bastian::FunctionRef func) {
+  result = func->GetArgument(0);
+}
+
+BASTIAN_OBJECT(Global) (bastian::ObjectRef obj) {
+  obj->Export("collect", CollectCodeCacheResult);
+}
+
+// The code cache changes how V8 compiles every script of the process, it
+// is only turned on in this binary so the other tests run with the
+// default options.
+class CodeCacheEnvironment : public ::testing::Environment {
+ public:
+  void SetUp() {
+    bastian::InitOptions options;
+    options.code_cache = true;
+    bastian::Init(options);
+  }
+
+  void TearDown() {
+    bastian::Shutdown();
+  }
+};
+
+static ::testing::Environment* const code_cache_environment =
+  ::testing::AddGlobalTestEnvironment(new CodeCacheEnvironment());
+
+TEST(V8CodeCache, RoundTrip) {
+  char directory[] = "/tmp/bastian-code-cache-XXXXXX";
+  ASSERT_TRUE(mkdtemp(directory) != NULL);
+
+  bastian::EngineOptions options;
+  options.code_cache_dir = directory;
+
+  bastian::Handle<bastian::Engine> producer = bastian::Engine::New(Global, options);
+  producer->Run("collect(function () { return 7; }())");
+  EXPECT_EQ(7, result->NumberValue());
+  EXPECT_EQ(1u, producer->ScriptCacheStats().code_cache_stores);
+
+  bastian::Handle<bastian::Engine> consumer = bastian::Engine::New(Global, options);
+  consumer->Run("collect(function () { return 7; }())");
+  EXPECT_EQ(7, result->NumberValue());
+  EXPECT_EQ(1u, consumer->ScriptCacheStats().code_cache_loads);
+
+  std::vector<std::string> paths;
+  DIR* listing = opendir(directory);
+  ASSERT_TRUE(listing != NULL);
+
+  while (struct dirent* entry = readdir(listing)) {
+    if (entry->d_name[0] != '.') {
+      paths.push_back(std::string(directory) + "/" + entry->d_name);
+    }
+  }
+
+  closedir(listing);
+  ASSERT_EQ(1u, paths.size());
+
+  // A blob of another build or snapshot is compiled again, not loaded.
+  FILE* blob = std::fopen(paths[0].c_str(), "r+b");
+  ASSERT_TRUE(blob != NULL);
+  std::fseek(blob, 16, SEEK_SET);
+  int fingerprint = std::fgetc(blob);
+  std::fseek(blob, 16, SEEK_SET);
+  std::fputc(fingerprint ^ 1, blob);
+  std::fclose(blob);
+
+  bastian::Handle<bastian::Engine> rebuilt = bastian::Engine::New(Global, options);
+  rebuilt->Run("collect(function () { return 7; }())");
+  EXPECT_EQ(7, result->NumberValue());
+  EXPECT_EQ(0u, rebuilt->ScriptCacheStats().code_cache_loads);
+
+  // Nor is a blob damaged on disk, which the engine would abort on.
+  blob = std::fopen(paths[0].c_str(), "r+b");
+  ASSERT_TRUE(blob != NULL);
+  std::fseek(blob, 16, SEEK_SET);
+  std::fputc(fingerprint, blob);
+  std::fseek(blob, -1, SEEK_END);
+  int last = std::fgetc(blob);
+  std::fseek(blob, -1, SEEK_END);
+  std::fputc(last ^ 0xff, blob);
+  std::fclose(blob);
+
+  bastian::Handle<bastian::Engine> damaged = bastian::Engine::New(Global, options);
+  damaged->Run("collect(function () { return 7; }())");
+  EXPECT_EQ(7, result->NumberValue());
+  EXPECT_EQ(0u, damaged->ScriptCacheStats().code_cache_loads);
+
+  unlink(paths[0].c_str());
+  rmdir(directory);
+}
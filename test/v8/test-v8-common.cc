@@ -1,10 +1,11 @@
+#include <gtest/gtest.h>
 #include <v8.h>
 #include <functional>
 #include <bastian.h>
 #include "test-v8-common.h"
 
 
-TestContext::TestContext() {
+TestContext::TestContext() : handle_scope_(v8::Isolate::GetCurrent()) {
   global_ = v8::ObjectTemplate::New(v8::Isolate::GetCurrent());
 }
 
@@ -26,3 +27,28 @@ void TestContext::RunJS(const char * rawSource) {
 
   script->Run();
 }
+
+
+BASTIAN_OBJECT(TestGlobal) (bastian::ObjectRef obj) {
+}
+
+// Tests building V8 objects directly need the main thread's isolate, the
+// engine created here keeps it alive until the tests are over.
+class TestEnvironment : public ::testing::Environment {
+ public:
+  void SetUp() {
+    bastian::Init();
+    engine_ = bastian::Engine::New(TestGlobal);
+  }
+
+  void TearDown() {
+    engine_->Dispose();
+    bastian::Shutdown();
+  }
+
+ private:
+  bastian::Handle<bastian::Engine> engine_;
+};
+
+static ::testing::Environment* const test_environment =
+  ::testing::AddGlobalTestEnvironment(new TestEnvironment());
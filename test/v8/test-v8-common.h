@@ -11,6 +11,7 @@ class TestContext {
     void RunJS(const char *);
 
   private:
+    v8::HandleScope handle_scope_;
     v8::Handle<v8::ObjectTemplate> global_;
 };
 
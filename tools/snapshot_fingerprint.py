@@ -0,0 +1,32 @@
+#!/usr/bin/env python
+
+# Writes a C++ file defining bastian::kSnapshotFingerprint, a digest of the
+# generated snapshot and of the build configuration. Code cache blobs are
+# only valid for the snapshot and the build which produced them.
+#
+#   snapshot_fingerprint.py <output.cc> <configuration> <snapshot.cc>...
+
+
+import hashlib
+import sys
+
+
+def fingerprint(configuration, paths):
+  digest = hashlib.sha1()
+  digest.update(configuration.encode('utf-8'))
+
+  for path in paths:
+    with open(path, 'rb') as source:
+      digest.update(source.read())
+
+  return digest.hexdigest()
+
+if __name__ == '__main__':
+  output = sys.argv[1]
+  value = fingerprint(sys.argv[2], sys.argv[3:])
+
+  with open(output, 'w') as generated:
+    generated.write('namespace bastian {\n')
+    generated.write('extern const char kSnapshotFingerprint[];\n')
+    generated.write('const char kSnapshotFingerprint[] = "%s";\n' % value)
+    generated.write('}  // namespace bastian\n')